@@ -0,0 +1,405 @@
+// bench.c drives the host build of the kernel subsystems (see 'make host').
+// It has two modes:
+//
+//     kernel-host bench
+//         times the page allocator, bifs lookups, process table operations
+//         and the scheduler, printing 'hbench <name> <min> <median> <max>'
+//         lines with nanoseconds per op, like kbench does in cycles. Being a
+//         plain host program, it can be run under perf, valgrind and the like.
+//
+//     kernel-host stress [seed] [rounds]
+//         hammers the same code with random operations, checking the
+//         invariants of the data structures along the way. Exits with status 1
+//         on the first violation.
+
+#include "kernel.h"
+#include "pagealloc.h"
+#include "bakedinfs.h"
+#include "fs.h"
+#include "string.h"
+#include "sysctl.h"
+#include "vdso.h"
+#include "strace.h"
+
+// defined in stubs.c
+void *host_mem_end();
+
+// defined in proc.c, not exported in proc.h
+void pid_hash_remove(process_t* proc);
+
+#define HBENCH_RUNS        9
+#define HBENCH_WARMUP_RUNS 2
+#define HBENCH_ITERS       10000
+
+typedef struct hbench_s {
+    char const *name;
+    void (*setup)();
+    void (*run)(uint32_t iters);
+    void (*teardown)();
+} hbench_t;
+
+void host_init() {
+    sysctl_init();
+    vdso_init();
+    strace_init();
+    init_paged_memory(host_mem_end());
+    init_process_table();
+    fs_init();
+}
+
+uint64_t host_nanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// host_new_proc adds a process to the table, like fork() does, minus the
+// stack.
+process_t* host_new_proc() {
+    process_t *proc = alloc_process();
+    if (proc) {
+        release(PROC_LOCK(proc));
+    }
+    return proc;
+}
+
+// host_free_proc removes a process from the table, like proc_exit() does,
+// minus the scheduling.
+void host_free_proc(process_t *proc) {
+    acquire(&proc_table.lock);
+    pid_hash_remove(proc);
+    proc_table.num_procs--;
+    PROC_STATE(proc) = PROC_STATE_AVAILABLE;
+    release(&proc_table.lock);
+}
+
+void host_free_all_procs() {
+    for (int i = 0; i < proc_table.capacity; i++) {
+        process_t *proc = proc_table.procs[i];
+        if (PROC_STATE(proc) != PROC_STATE_AVAILABLE) {
+            host_free_proc(proc);
+        }
+    }
+    proc_table.curr_proc = 0;
+    proc_table.is_idle = 1;
+}
+
+// host_fill_procs adds processes until there are n of them.
+void host_fill_procs(int n) {
+    while (proc_table.num_procs < n && host_new_proc())
+        ;
+}
+
+void *held_pages[MAX_PAGES];
+uint32_t num_held_pages;
+
+// hold_pages allocates every other page, so that the allocator has to skip
+// over half of them, and the free ones are all fragmented.
+void hold_pages() {
+    num_held_pages = 0;
+    void *all[MAX_PAGES];
+    uint32_t n = 0;
+    void *p;
+    while ((p = allocate_page())) {
+        all[n++] = p;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        if (i % 2) {
+            release_page(all[i]);
+        } else {
+            held_pages[num_held_pages++] = all[i];
+        }
+    }
+}
+
+void unhold_pages() {
+    for (uint32_t i = 0; i < num_held_pages; i++) {
+        release_page(held_pages[i]);
+    }
+    num_held_pages = 0;
+    page_alloc_policy = PAGE_ALLOC_FIRST_FIT;
+}
+
+void setup_next_fit() {
+    hold_pages();
+    page_alloc_policy = PAGE_ALLOC_NEXT_FIT;
+}
+
+void bench_page(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        release_page(allocate_page());
+    }
+}
+
+void bench_pages4(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        void *p = allocate_pages(4);
+        for (int j = 0; p && j < 4; j++) {
+            release_page((char*)p + j * PAGE_SIZE);
+        }
+    }
+}
+
+void bench_bifs_open(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        bifs_open("/home/smoke-test.sh", 0);
+    }
+}
+
+void setup_full_table() {
+    host_fill_procs(MAX_PROCS);
+}
+
+void setup_sleeping_table() {
+    host_fill_procs(MAX_PROCS);
+    for (int i = 0; i < proc_table.capacity; i++) {
+        proc_table.states[i] = PROC_STATE_SLEEPING;
+        proc_table.wakeup_times[i] = -1;
+    }
+    proc_table.states[0] = PROC_STATE_READY;
+}
+
+void bench_find_ready_proc(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        find_ready_proc(0);
+    }
+}
+
+void bench_find_proc(uint32_t iters) {
+    uint32_t max_pid = proc_table.pid_counter;
+    for (uint32_t i = 0; i < iters; i++) {
+        acquire(&proc_table.lock);
+        find_proc(i % max_pid);
+        release(&proc_table.lock);
+    }
+}
+
+void bench_alloc_free_proc(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        host_free_proc(host_new_proc());
+    }
+}
+
+// setup_round_robin makes a handful of ready processes for
+// schedule_user_process() to switch between.
+void setup_round_robin() {
+    host_fill_procs(8);
+}
+
+void bench_schedule(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        schedule_user_process();
+    }
+}
+
+hbench_t hbenches[] = {
+    {"page",                0,                    bench_page,            0},
+    {"page_first_fit_half", hold_pages,           bench_page,            unhold_pages},
+    {"page_next_fit_half",  setup_next_fit,       bench_page,            unhold_pages},
+    {"pages4_fragmented",   hold_pages,           bench_pages4,          unhold_pages},
+    {"bifs_open",           0,                    bench_bifs_open,       0},
+    {"find_ready_proc",     setup_sleeping_table, bench_find_ready_proc, host_free_all_procs},
+    {"find_proc",           setup_full_table,     bench_find_proc,       host_free_all_procs},
+    {"alloc_free_proc",     0,                    bench_alloc_free_proc, host_free_all_procs},
+    {"schedule_8_ready",    setup_round_robin,    bench_schedule,        host_free_all_procs},
+};
+
+int cmp_u64(void const *a, void const *b) {
+    uint64_t x = *(uint64_t const*)a;
+    uint64_t y = *(uint64_t const*)b;
+    return x < y ? -1 : x > y;
+}
+
+void run_hbench(hbench_t *b) {
+    uint64_t samples[HBENCH_RUNS];
+    if (b->setup) {
+        b->setup();
+    }
+    for (int i = 0; i < HBENCH_WARMUP_RUNS; i++) {
+        b->run(HBENCH_ITERS);
+    }
+    for (int i = 0; i < HBENCH_RUNS; i++) {
+        uint64_t start = host_nanos();
+        b->run(HBENCH_ITERS);
+        samples[i] = (host_nanos() - start) / HBENCH_ITERS;
+    }
+    if (b->teardown) {
+        b->teardown();
+    }
+    qsort(samples, HBENCH_RUNS, sizeof(samples[0]), cmp_u64);
+    printf("hbench %s %lu %lu %lu\n", b->name, samples[0],
+           samples[HBENCH_RUNS / 2], samples[HBENCH_RUNS - 1]);
+}
+
+#define CHECK(cond, ...) do {                    \
+        if (!(cond)) {                           \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+            printf(__VA_ARGS__);                 \
+            printf("\n");                        \
+            exit(1);                             \
+        }                                        \
+    } while (0)
+
+// stress_pages randomly allocates and releases pages, single ones and runs of
+// them, under both allocation policies, and checks that no page is handed
+// out twice and that the free count adds up.
+void stress_pages(uint32_t rounds) {
+    static char owner[MAX_PAGES]; // 0 = free, else the size of the run + 1
+    char *base = (char*)paged_memory.pages[0].ptr;
+    uint32_t npages = paged_memory.num_pages;
+    uint32_t used = 0;
+    for (uint32_t r = 0; r < rounds; r++) {
+        page_alloc_policy = rand() % 2 ? PAGE_ALLOC_NEXT_FIT : PAGE_ALLOC_FIRST_FIT;
+        int op = rand() % 3;
+        if (op == 0 || op == 1) {
+            uint32_t n = op == 0 ? 1 : 1 + rand() % 4;
+            char *p = n == 1 ? allocate_page() : allocate_pages(n);
+            if (!p) {
+                CHECK(used + n > npages || n > 1,
+                      "allocation of %u failed with %u of %u pages used",
+                      n, used, npages);
+                continue;
+            }
+            CHECK((p - base) % PAGE_SIZE == 0, "unaligned page %p", p);
+            uint32_t first = (p - base) / PAGE_SIZE;
+            CHECK(first + n <= npages, "page %p out of range", p);
+            for (uint32_t i = first; i < first + n; i++) {
+                CHECK(!owner[i], "page %u handed out twice", i);
+                owner[i] = 1;
+            }
+            used += n;
+        } else if (used > 0) {
+            uint32_t i = rand() % npages;
+            while (!owner[i]) {
+                i = (i + 1) % npages;
+            }
+            release_page(base + i * PAGE_SIZE);
+            owner[i] = 0;
+            used--;
+        }
+        CHECK(count_free_pages() == npages - used,
+              "free count %u, expected %u", count_free_pages(), npages - used);
+    }
+    for (uint32_t i = 0; i < npages; i++) {
+        if (owner[i]) {
+            release_page(base + i * PAGE_SIZE);
+            owner[i] = 0;
+        }
+    }
+    page_alloc_policy = PAGE_ALLOC_FIRST_FIT;
+}
+
+// stress_procs randomly creates and frees processes, checking that find_proc
+// finds exactly the live ones.
+void stress_procs(uint32_t rounds) {
+    static uint32_t live[MAX_PROCS];
+    uint32_t nlive = 0;
+    for (uint32_t r = 0; r < rounds; r++) {
+        if (rand() % 2 && nlive < MAX_PROCS) {
+            process_t *p = host_new_proc();
+            CHECK(p, "alloc_process failed with %u processes", nlive);
+            live[nlive++] = p->pid;
+            if (nlive == MAX_PROCS) {
+                CHECK(!host_new_proc(), "alloc_process beyond MAX_PROCS");
+            }
+        } else if (nlive > 0) {
+            uint32_t i = rand() % nlive;
+            acquire(&proc_table.lock);
+            process_t *p = find_proc(live[i]);
+            release(&proc_table.lock);
+            CHECK(p && p->pid == live[i], "pid %u not found", live[i]);
+            host_free_proc(p);
+            acquire(&proc_table.lock);
+            p = find_proc(live[i]);
+            release(&proc_table.lock);
+            CHECK(!p, "freed pid %u still found", live[i]);
+            live[i] = live[--nlive];
+        }
+        CHECK(proc_table.num_procs == nlive, "num_procs %d, expected %u",
+              proc_table.num_procs, nlive);
+    }
+    host_free_all_procs();
+}
+
+// stress_sched gives processes random states and checks that find_ready_proc
+// picks a runnable one, and that it's fair: with n ready processes, n picks
+// in a row visit each of them once.
+void stress_sched(uint32_t rounds) {
+    host_fill_procs(1 + rand() % MAX_PROCS);
+    int cap = proc_table.capacity;
+    uint64_t now = time_get_now();
+    for (uint32_t r = 0; r < rounds; r++) {
+        int ready = 0;
+        for (int i = 0; i < cap; i++) {
+            uint32_t state = proc_table.states[i];
+            if (state == PROC_STATE_AVAILABLE) {
+                continue;
+            }
+            if (rand() % 2) {
+                proc_table.states[i] = PROC_STATE_READY;
+                ready++;
+            } else {
+                proc_table.states[i] = PROC_STATE_SLEEPING;
+                proc_table.wakeup_times[i] = now + (uint64_t)ONE_SECOND * 1000;
+            }
+        }
+        int start = rand() % cap;
+        process_t *p = find_ready_proc(start);
+        if (!ready) {
+            CHECK(!p, "picked slot %d with nothing ready", proc_table.curr_proc);
+            continue;
+        }
+        CHECK(p && PROC_STATE(p) == PROC_STATE_READY, "picked a non-ready process");
+        static char seen[MAX_PROCS];
+        for (int i = 0; i < cap; i++) {
+            seen[i] = 0;
+        }
+        seen[p->slot] = 1;
+        for (int i = 1; i < ready; i++) {
+            p = find_ready_proc(proc_table.curr_proc);
+            CHECK(!seen[p->slot], "slot %d picked twice in a round", p->slot);
+            seen[p->slot] = 1;
+        }
+    }
+    host_free_all_procs();
+}
+
+// stress_bifs checks the lookups of existing and missing paths.
+void stress_bifs(uint32_t rounds) {
+    char const *found[] = {"/readme.txt", "/home/read.me", "/home/smoke-test.sh"};
+    char const *missing[] = {"/nope", "/home/nope", "/nope/read.me", "home/read.me"};
+    for (uint32_t r = 0; r < rounds; r++) {
+        char const *path = found[rand() % ARRAY_LENGTH(found)];
+        CHECK(bifs_open(path, 0), "%s not found", path);
+        path = missing[rand() % ARRAY_LENGTH(missing)];
+        CHECK(!bifs_open(path, 0), "%s found", path);
+    }
+}
+
+int main(int argc, char const *argv[]) {
+    if (argc < 2) {
+        printf("usage: %s bench | stress [seed] [rounds]\n", argv[0]);
+        return 2;
+    }
+    host_init();
+    if (!strncmp(argv[1], "bench", 6)) {
+        for (int i = 0; i < ARRAY_LENGTH(hbenches); i++) {
+            run_hbench(&hbenches[i]);
+        }
+        return 0;
+    }
+    if (!strncmp(argv[1], "stress", 7)) {
+        unsigned seed = argc > 2 ? strtoul(argv[2], 0, 0) : time(0);
+        uint32_t rounds = argc > 3 ? strtoul(argv[3], 0, 0) : 100000;
+        printf("stress: seed=%u rounds=%u\n", seed, rounds);
+        srand(seed);
+        stress_pages(rounds);
+        stress_procs(rounds);
+        stress_sched(rounds / 100);
+        stress_bifs(rounds);
+        printf("stress: OK\n");
+        return 0;
+    }
+    printf("unknown mode: %s\n", argv[1]);
+    return 2;
+}
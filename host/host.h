@@ -0,0 +1,20 @@
+#ifndef _HOST_H_
+#define _HOST_H_
+
+// host.h is force-included (with -include) into every file of the host build,
+// see 'make host'. It pulls in the libc headers before sys.h gets a chance to
+// #define the fixed-width integer types, and makes sys.h pick the rv64 types,
+// which match the host's LP64 ones.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define __riscv_xlen 64
+
+// time_get_now() in stubs.c pretends to be a 10MHz timer, like the one QEMU
+// emulates
+#define ONE_SECOND (10*1000*1000)
+
+#endif // ifndef _HOST_H_
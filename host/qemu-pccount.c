@@ -0,0 +1,136 @@
+// qemu-pccount is a QEMU TCG plugin that counts how many times each guest
+// instruction gets executed, which attributes the cost of a run exactly and
+// without any help from the guest. It's built and loaded by
+// 'qemu-launcher.py --profile', which then maps the counts to functions with
+// scripts/profile.py --pccount.
+//
+// At exit, it writes a line per executed instruction to the file given with
+// the outfile=<path> plugin arg (pccount.txt by default):
+//
+//     pccount <pc> <count>
+//
+// It only uses the parts of the plugin API that have been there since QEMU
+// 5.0, and doesn't need glib itself.
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <qemu-plugin.h>
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+// pccount_t is the counter of a single pc. Counters are allocated one by one
+// and never move, since their addresses are handed to the exec callbacks.
+typedef struct pccount_s {
+    uint64_t pc;
+    uint64_t count;
+} pccount_t;
+
+// The counters are found by pc in an open-addressing hash table, which is
+// only used at translation time, under pccount_lock. The same pc can be
+// translated many times, e.g. after a TB flush, and always gets the same
+// counter.
+pccount_t **pccount_table;
+size_t pccount_capacity;
+size_t pccount_used;
+pthread_mutex_t pccount_lock = PTHREAD_MUTEX_INITIALIZER;
+char const *pccount_outfile = "pccount.txt";
+
+size_t pccount_slot(pccount_t **table, size_t capacity, uint64_t pc) {
+    size_t i = (size_t)((pc >> 1) * 0x9e3779b97f4a7c15ull) & (capacity - 1);
+    while (table[i] && table[i]->pc != pc) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return i;
+}
+
+void pccount_grow() {
+    size_t capacity = pccount_capacity ? pccount_capacity * 2 : 4096;
+    pccount_t **table = calloc(capacity, sizeof(*table));
+    if (!table) {
+        abort();
+    }
+    for (size_t i = 0; i < pccount_capacity; i++) {
+        if (pccount_table[i]) {
+            table[pccount_slot(table, capacity, pccount_table[i]->pc)] =
+                pccount_table[i];
+        }
+    }
+    free(pccount_table);
+    pccount_table = table;
+    pccount_capacity = capacity;
+}
+
+// pccount_get returns the counter of pc, creating it if needed. MUST be called
+// with pccount_lock held.
+pccount_t *pccount_get(uint64_t pc) {
+    // keep the table at most half full:
+    if ((pccount_used + 1) * 2 > pccount_capacity) {
+        pccount_grow();
+    }
+    size_t i = pccount_slot(pccount_table, pccount_capacity, pc);
+    if (!pccount_table[i]) {
+        pccount_t *entry = calloc(1, sizeof(*entry));
+        if (!entry) {
+            abort();
+        }
+        entry->pc = pc;
+        pccount_table[i] = entry;
+        pccount_used++;
+    }
+    return pccount_table[i];
+}
+
+void pccount_insn_exec(unsigned int vcpu_index, void *udata) {
+    pccount_t *entry = udata;
+    __atomic_fetch_add(&entry->count, 1, __ATOMIC_RELAXED);
+}
+
+void pccount_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb) {
+    size_t n = qemu_plugin_tb_n_insns(tb);
+    pthread_mutex_lock(&pccount_lock);
+    for (size_t i = 0; i < n; i++) {
+        struct qemu_plugin_insn *insn = qemu_plugin_tb_get_insn(tb, i);
+        pccount_t *entry = pccount_get(qemu_plugin_insn_vaddr(insn));
+        qemu_plugin_register_vcpu_insn_exec_cb(insn, pccount_insn_exec,
+                                               QEMU_PLUGIN_CB_NO_REGS, entry);
+    }
+    pthread_mutex_unlock(&pccount_lock);
+}
+
+void pccount_exit(qemu_plugin_id_t id, void *p) {
+    FILE *f = fopen(pccount_outfile, "w");
+    if (!f) {
+        perror(pccount_outfile);
+        return;
+    }
+    pthread_mutex_lock(&pccount_lock);
+    for (size_t i = 0; i < pccount_capacity; i++) {
+        pccount_t *entry = pccount_table[i];
+        if (entry && entry->count) {
+            fprintf(f, "pccount 0x%" PRIx64 " %" PRIu64 "\n", entry->pc,
+                    entry->count);
+        }
+    }
+    pthread_mutex_unlock(&pccount_lock);
+    fclose(f);
+}
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
+                                           const qemu_info_t *info,
+                                           int argc, char **argv) {
+    for (int i = 0; i < argc; i++) {
+        if (!strncmp(argv[i], "outfile=", 8)) {
+            pccount_outfile = strdup(argv[i] + 8);
+        } else {
+            fprintf(stderr, "qemu-pccount: unknown arg: %s\n", argv[i]);
+            return -1;
+        }
+    }
+    qemu_plugin_register_vcpu_tb_trans_cb(id, pccount_tb_trans);
+    qemu_plugin_register_atexit_cb(id, pccount_exit, NULL);
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Host implementations of the bits of the kernel that the host build doesn't
+// compile: the spinlocks, CSR accessors, timer and console. They're just
+// enough for pagealloc.c, bakedinfs.c, fs.c, string.c and proc.c to run as a
+// plain host program, see bench.c.
+
+#include <stdarg.h>
+
+#include "kernel.h"
+#include "syscalls.h"
+#include "programs.h"
+
+// HOST_MEM_PAGES is the size of the memory arena handed to the page
+// allocator. It's a little larger than MAX_PAGES, so that the allocator gets
+// MAX_PAGES whole pages after aligning the start.
+#define HOST_MEM_PAGES (MAX_PAGES + 1)
+
+// On the target stack_top is a linker symbol marking the end of the kernel
+// image, where the paged memory starts. Here it's the arena itself, under a
+// different C name, since pmp.h declares stack_top as a single pointer.
+char host_mem[HOST_MEM_PAGES * PAGE_SIZE] __asm__("stack_top")
+    __attribute__((aligned(PAGE_SIZE)));
+
+void *host_mem_end() {
+    return host_mem + sizeof(host_mem);
+}
+
+// The syscall table isn't compiled in, strace.c only needs these to exist:
+syscall_fn_t syscall_vector[SYS_NR_COUNT];
+syscall_info_t syscall_info[SYS_NR_COUNT];
+
+void acquire(spinlock *lock) {
+    while (__sync_lock_test_and_set(lock, 1))
+        ;
+}
+
+void release(spinlock *lock) {
+    __sync_lock_release(lock);
+}
+
+void kprintf(char const *msg, ...) {
+    va_list args;
+    va_start(args, msg);
+    vprintf(msg, args);
+    va_end(args);
+}
+
+// time_get_now returns the monotonic clock in ONE_SECOND units, i.e. ticks of
+// the same 10MHz timer that QEMU emulates.
+uint64_t time_get_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * ONE_SECOND + ts.tv_nsec / 100;
+}
+
+unsigned int get_mhartid() {
+    return 0;
+}
+
+void set_timer_after(uint64_t delta) {}
+void enable_interrupts() {}
+void disable_interrupts() {}
+void park_hart() {}
+void set_user_mode() {}
+void set_mscratch(void* ptr) {}
+void set_mcounteren(unsigned int value) {}
+
+// There are no counters to read on the host, perf.c just sees them stand
+// still:
+uint64_t get_mcycle() { return 0; }
+uint64_t get_minstret() { return 0; }
+uint64_t get_mhpmcounter3() { return 0; }
+uint64_t get_mhpmcounter4() { return 0; }
+void set_mhpmevent3(regsize_t event) {}
+void set_mhpmevent4(regsize_t event) {}
+
+// User processes never run on the host, so there's no point painting their
+// stacks, and there are no kernel stacks:
+void stack_paint(void *lo, void *hi) {}
+uint32_t stack_max_depth(void *lo, void *hi) { return 0; }
+uint32_t kstack_max_depth(uint32_t hart) { return 0; }
+uint32_t num_harts = 1;
+
+// No userland programs are baked into the host build:
+void init_test_processes() {}
+
+user_program_t* find_user_program(char const *name) {
+    return 0;
+}
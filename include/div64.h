@@ -0,0 +1,16 @@
+#ifndef _DIV64_H_
+#define _DIV64_H_
+
+#include "sys.h"
+
+// udivmod64 divides a 64-bit number by a 32-bit one and stores the remainder
+// in *rem, unless rem is NULL. On rv64 this is a plain division, but rv32 has
+// no instruction for it and we don't link against libgcc, so it's done the
+// long way there. Use it instead of '/' and '%' on any 64-bit value that needs
+// to build for both.
+uint64_t udivmod64(uint64_t n, uint32_t d, uint32_t *rem);
+
+// udiv64 is a shorthand for udivmod64 without the remainder.
+uint64_t udiv64(uint64_t n, uint32_t d);
+
+#endif // ifndef _DIV64_H_
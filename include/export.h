@@ -0,0 +1,58 @@
+#ifndef _EXPORT_H_
+#define _EXPORT_H_
+
+#include "sys.h"
+#include "spinlock.h"
+#include "syscalls.h"
+
+// export writes the kernel's diagnostic buffers straight to files on the
+// host with semihosting, instead of having a program print them to the UART
+// for the host to scrape. It's on when the kernel is booted with the export
+// bootarg, which qemu-launcher.py --export-dir adds along with enabling
+// semihosting in QEMU and running it in the given directory.
+//
+// Each kind of data goes to a file of its own (see EXPORT_* in syscalls.h),
+// which is made of an export_header_t followed by the raw records as they
+// are in memory: ktrace_event_t or prof_sample_t. Every export() call writes
+// all records buffered at the moment and removes them from the buffer, a
+// contiguous span at a time.
+
+#define EXPORT_MAGIC   0x5058454b // "KEXP"
+#define EXPORT_VERSION 1
+
+#define EXPORT_NUM_KINDS 2
+
+typedef struct export_header_s {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t kind;          // EXPORT_*
+    uint32_t record_size;   // sizeof the record struct
+    uint32_t timebase;      // timer ticks per second
+    uint32_t xlen;          // 32 or 64, the size of pc in prof_sample_t
+} export_header_t;
+
+// export_kind_t describes a kind of data: the file it goes to, and the
+// function that writes all buffered records of it to the host file fd and
+// returns their number, or -1 on error.
+typedef struct export_kind_s {
+    char const *file_name;
+    uint32_t record_size;
+    int32_t (*dump)(int32_t fd);
+} export_kind_t;
+
+// Lock should be acquired to access files.
+typedef struct export_s {
+    spinlock lock;
+    uint32_t enabled;
+    int32_t files[EXPORT_NUM_KINDS]; // semihosting handles, -1 if closed
+} export_t;
+
+// defined in export.c
+extern export_t export_state;
+
+void export_init();
+
+// export_dump implements the export syscall.
+int32_t export_dump(uint32_t kind, uint32_t flags);
+
+#endif // ifndef _EXPORT_H_
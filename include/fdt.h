@@ -31,4 +31,8 @@ typedef struct fdt_header_s {
 void fdt_init(uintptr_t header_addr);
 char const* fdt_get_bootargs();
 
+// fdt_has_bootarg returns true if word is one of the space-separated words in
+// bootargs.
+int fdt_has_bootarg(char const *word);
+
 #endif // ifndef _FDT_H_
@@ -20,14 +20,17 @@
 #define FFLAGS_DIR         (1 << 3)
 #define FFLAGS_UART_STREAM (1 << 8)
 #define FFLAGS_BIFS_FILE   (1 << 9)
+#define FFLAGS_PROCFS_FILE (1 << 10)
 
 typedef struct file_s {
     uint32_t flags;    // FFLAGS_* bit flags
     uint32_t position;
     uint32_t mode;     // FDMODE_*
     void     *fs_file; // a pointer to the underlying FS-level file struct
+    uint32_t fs_id;    // FS-specific identifier, e.g. the pid of a /proc/<pid>/ file
     int32_t (*read)(struct file_s *f, uint32_t pos, void *buf, uint32_t size);
     int32_t (*write)(struct file_s *f, uint32_t pos, void *buf, uint32_t nbytes);
+    void    (*close)(struct file_s *f); // releases fs_file, may be null
 } file_t;
 
 typedef struct file_table_s {
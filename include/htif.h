@@ -0,0 +1,38 @@
+#ifndef _HTIF_H_
+#define _HTIF_H_
+
+#include "sys.h"
+
+// HTIF is the host-target interface of Spike (and of the riscv-tests
+// environment), which Spike uses instead of a UART and a test device. The
+// target writes a command to tohost, and the host picks it up, clears tohost
+// and writes its reply, if any, to fromhost. Both are found by their ELF
+// symbol names.
+//
+// A command is the device in bits 63..56, the device command in 55..48 and the
+// payload in the rest. The only device used here is the console:
+
+#define HTIF_DEV_CONSOLE  1
+#define HTIF_CMD_GETCHAR  0
+#define HTIF_CMD_PUTCHAR  1
+
+#define HTIF_COMMAND(dev, cmd, payload) \
+    (((uint64_t)(dev) << 56) | ((uint64_t)(cmd) << 48) | (payload))
+
+// Device 0 command 0 is a syscall, except that an odd payload means exit with
+// the status in the upper bits, see poweroff in baremetal-poweroff.s.
+//
+// The commands are 64-bit, and a 32-bit hart can't write them atomically, so
+// only the RV64 Spike build uses HTIF. uart-print.s and baremetal-poweroff.s
+// have their own copies of these, under .ifdef HTIF.
+
+extern volatile uint64_t tohost;
+extern volatile uint64_t fromhost;
+
+// htif_putchar prints ch on Spike's console and waits until it's been taken.
+void htif_putchar(char ch);
+
+// htif_getchar waits for a character from Spike's console and returns it.
+char htif_getchar();
+
+#endif // ifndef _HTIF_H_
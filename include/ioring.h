@@ -0,0 +1,51 @@
+#ifndef _IORING_H_
+#define _IORING_H_
+
+#include "sys.h"
+
+// An ioring is a pair of rings that a process shares with the kernel to batch
+// syscalls: the process queues several operations in the submission ring and
+// has them all executed with a single ioring_enter() trap. The kernel also
+// drains the ring of the running process on the scheduler tick, so a process
+// that doesn't need the results right away doesn't have to trap at all. The
+// results are posted to the completion ring, where the process reaps them
+// without any further traps.
+//
+// The ring lives in the process's own memory, which for now is its stack page,
+// so it has to be kept small. The head and tail counters run freely and wrap
+// around, a slot is at (counter & IORING_MASK).
+
+// IORING_ENTRIES is the number of slots in each ring, must be a power of two.
+#define IORING_ENTRIES 4
+#define IORING_MASK    (IORING_ENTRIES - 1)
+
+#define IORING_OP_NOP   0
+#define IORING_OP_READ  1 // read(fd, addr, len)
+#define IORING_OP_WRITE 2 // write(fd, addr, len)
+#define IORING_OP_OPEN  3 // open(addr, len), len is the flags
+#define IORING_OP_CLOSE 4 // close(fd)
+#define IORING_OP_SLEEP 5 // sleep(len), puts the process to sleep
+
+typedef struct ioring_sqe_s {
+    uint32_t op;        // IORING_OP_*
+    uint32_t fd;
+    regsize_t addr;
+    uint32_t len;
+    uint32_t user_data; // passed back as is in the completion
+} ioring_sqe_t;
+
+typedef struct ioring_cqe_s {
+    uint32_t user_data;
+    int32_t res;        // what the equivalent syscall would have returned
+} ioring_cqe_t;
+
+typedef struct ioring_s {
+    volatile uint32_t sq_head; // advanced by the kernel as it consumes submissions
+    volatile uint32_t sq_tail; // advanced by the process as it submits
+    volatile uint32_t cq_head; // advanced by the process as it reaps completions
+    volatile uint32_t cq_tail; // advanced by the kernel as it completes
+    ioring_sqe_t sqes[IORING_ENTRIES];
+    ioring_cqe_t cqes[IORING_ENTRIES];
+} ioring_t;
+
+#endif // ifndef _IORING_H_
@@ -0,0 +1,37 @@
+#ifndef _KBENCH_H_
+#define _KBENCH_H_
+
+#include "sys.h"
+
+// kbench is a set of microbenchmarks of kernel primitives that can't be timed
+// precisely from userland. It runs instead of the init program when the
+// kernel is booted with the bench bootarg, prints a line per benchmark:
+//
+//     kbench <name> <min> <median> <max>
+//
+// with the cycles per operation across KBENCH_RUNS runs, and powers off. The
+// name of a benchmark whose cost depends on the size of what it works on, like
+// the number of process table slots, is suffixed with that size, e.g.
+// find_ready_proc/256, so that results for different sizes aren't compared.
+
+// KBENCH_RUNS is the number of timed runs of each benchmark, after
+// KBENCH_WARMUP_RUNS untimed ones.
+#define KBENCH_RUNS        9
+#define KBENCH_WARMUP_RUNS 2
+
+// kbench_t describes a single benchmark. setup, if not null, is called once
+// before the runs, and returns the size of what the benchmark works on, or 0
+// if it doesn't matter. run performs iters operations.
+typedef struct kbench_s {
+    char const *name;
+    int (*setup)();
+    void (*run)(uint32_t iters);
+    uint32_t iters;
+} kbench_t;
+
+// kbench_run_all runs all benchmarks and powers off. Called early, from
+// init_test_processes(), with interrupts still disabled, so the runs are not
+// disturbed by the scheduler.
+void kbench_run_all();
+
+#endif // ifndef _KBENCH_H_
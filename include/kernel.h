@@ -5,7 +5,21 @@
 #include "pmp.h"
 #include "proc.h"
 
+// KERNEL_SCHEDULER_TICK_TIME is the default length of the scheduler tick. The
+// actual value is in sched_tick_time, which can be changed at runtime via the
+// sched.tick sysctl, within the MIN..MAX range.
 #define KERNEL_SCHEDULER_TICK_TIME (ONE_SECOND)
+#define KERNEL_SCHEDULER_TICK_MIN  (ONE_SECOND / 1000)
+#define KERNEL_SCHEDULER_TICK_MAX  (ONE_SECOND * 10)
+
+// KERNEL_HALT_ON_EXCEPTION is the default for halt_on_exception, which tells
+// the trap handler in boot.s whether to hang the machine after reporting an
+// exception, or to return to the faulting process. Can be changed at runtime
+// via the kernel.halt_on_exception sysctl.
+#define KERNEL_HALT_ON_EXCEPTION 1
+
+extern uint32_t sched_tick_time;   // defined in proc.c
+extern uint32_t halt_on_exception; // defined in kernel.c
 
 void kinit(uintptr_t fdt_header_addr);
 void init_trap_vector();
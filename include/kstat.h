@@ -0,0 +1,69 @@
+#ifndef _KSTAT_H_
+#define _KSTAT_H_
+
+#include "sys.h"
+#include "riscv.h"
+#include "syscalls.h"
+
+// kstat is a set of always-on kernel event counters: traps, timer
+// interrupts, syscalls, context switches and so on, see kstat_counts_t. Each
+// hart has its own block of counters, in a cache line of its own, and only
+// ever increments its own, so no locks are needed. They're summed up when
+// read, by sysinfo().
+//
+// The counters are 32-bit and wrap around; readers are expected to look at
+// the differences between two readings, see the vmstat program.
+//
+// Each hart also keeps track of how its time splits between the KSTAT_CPU_*
+// states: every transition charges the time since the previous one to the
+// state the hart is leaving. Traps move it to the kernel or irq state, the
+// return from a trap to user or idle, depending on where it returns to, and
+// the scheduler to idle when it parks the hart.
+
+typedef struct kstat_hart_s {
+    kstat_counts_t counts;
+    uint32_t cpu_active;                    // set by kstat_cpu_init()
+    uint32_t cpu_state;                     // KSTAT_CPU_*
+    uint64_t cpu_since;                     // when it got into cpu_state
+    uint64_t cpu_time[KSTAT_CPU_STATES];    // time in each state, in ticks
+} __attribute__((aligned(CACHE_LINE_SIZE))) kstat_hart_t;
+
+typedef struct kstat_s {
+    kstat_hart_t harts[MAX_HARTS];
+} kstat_t;
+
+// defined in kstat.c
+extern kstat_t kstat;
+
+// KSTAT_INC increments counter, a field of kstat_counts_t, on the current
+// hart.
+#define KSTAT_INC(counter) (kstat.harts[get_mhartid()].counts.counter++)
+
+// KSTAT_ADD is the same, but adds n.
+#define KSTAT_ADD(counter, n) (kstat.harts[get_mhartid()].counts.counter += (n))
+
+// kstat_cpu_init starts the time accounting on the current hart, in the
+// kernel state. Harts that never call it are left out of the sums.
+void kstat_cpu_init();
+
+// kstat_cpu_switch charges the time since the last switch to the state the
+// current hart was in, and puts it in state.
+void kstat_cpu_switch(uint32_t state);
+
+// kstat_trap is called from the trap handler in boot.s, on every trap, and
+// kstat_trap_exit from ret_to_user, when returning from one.
+void kstat_trap(regsize_t mcause);
+void kstat_trap_exit();
+
+// kstat_sum adds up the counters of all harts in sum.
+void kstat_sum(kstat_counts_t *sum);
+
+// kstat_cpu_read fills times with the time hart spent in each KSTAT_CPU_*
+// state, up to now. Returns 0, or -1 if the hart isn't accounted.
+int32_t kstat_cpu_read(uint32_t hart, uint64_t *times);
+
+// kstat_cpu_sum adds up kstat_cpu_read() of all harts in times, and returns
+// the number of harts summed.
+uint32_t kstat_cpu_sum(uint64_t *times);
+
+#endif // ifndef _KSTAT_H_
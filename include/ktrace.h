@@ -0,0 +1,87 @@
+#ifndef _KTRACE_H_
+#define _KTRACE_H_
+
+#include "sys.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "syscalls.h"
+
+// ktrace is a timeline of kernel events: context switches, wakeups, syscalls,
+// traps and page allocations. Static tracepoints across the kernel record
+// them with KTRACE() into a ring buffer per hart, and the ktrace_read()
+// syscall reads them out. The ktrace program prints them, and
+// scripts/ktrace-to-chrome.py turns its output into a Chrome trace that can be
+// opened in Perfetto.
+//
+// Tracing is off by default and costs a single load and branch per
+// tracepoint then. It's switched at runtime with the ktrace.enable sysctl,
+// and ktrace.mask picks the events to record, a bit per KTRACE_EV_* number.
+// When a ring is full, the oldest events in it are overwritten.
+//
+// The syscalls of the process set in the ktrace.ignore_pid sysctl aren't
+// recorded. That's for the process reading out the events, which would
+// otherwise keep generating more of them as it prints them.
+
+// KTRACE_ENTRIES is the size of each hart's ring buffer, must be a power of 2.
+#ifndef KTRACE_ENTRIES
+#define KTRACE_ENTRIES 16
+#endif
+
+// The events and their args. scripts/ktrace-to-chrome.py parses these
+// defines, so keep them one per line.
+#define KTRACE_EV_SWITCH     1  // pid of the old process or -1, pid of the new one
+#define KTRACE_EV_IDLE       2  // pid of the old process or -1
+#define KTRACE_EV_WAKEUP     3  // pid
+#define KTRACE_EV_SYSCALL    4  // pid, syscall number
+#define KTRACE_EV_SYSRET     5  // pid, return value
+#define KTRACE_EV_TIMER      6  // pid or -1 if idle, interrupted pc
+#define KTRACE_EV_TRAP       7  // mcause, mepc
+#define KTRACE_EV_PAGE_ALLOC 8  // address, number of pages
+#define KTRACE_EV_PAGE_FREE  9  // address, number of pages
+#define KTRACE_EV_FORK       10 // pid of the parent, pid of the child
+#define KTRACE_EV_EXIT       11 // pid
+
+typedef struct ktrace_ring_s {
+    spinlock lock;
+    uint32_t head;      // number of events ever written
+    uint32_t tail;      // number of events ever read or overwritten
+    uint32_t dropped;   // number of events overwritten before being read
+    ktrace_event_t events[KTRACE_ENTRIES];
+} __attribute__((aligned(CACHE_LINE_SIZE))) ktrace_ring_t;
+
+typedef struct ktrace_s {
+    uint32_t enable;    // the ktrace.enable sysctl
+    uint32_t mask;      // the ktrace.mask sysctl
+    uint32_t ignore_pid; // the ktrace.ignore_pid sysctl, -1 for none
+    ktrace_ring_t harts[MAX_HARTS];
+} ktrace_t;
+
+// defined in ktrace.c
+extern ktrace_t ktrace;
+
+// KTRACE is a tracepoint: it records event with its two args if tracing is
+// on. The args, which may be pointers, are truncated to 32 bits.
+#define KTRACE(event, arg0, arg1)                                       \
+    do {                                                                \
+        if (ktrace.enable) {                                            \
+            ktrace_record((event), (uint32_t)(regsize_t)(arg0),         \
+                          (uint32_t)(regsize_t)(arg1));                 \
+        }                                                               \
+    } while (0)
+
+void ktrace_init();
+
+void ktrace_record(uint32_t event, uint32_t arg0, uint32_t arg1);
+
+// ktrace_trap is the tracepoint of the exception handler in boot.s.
+void ktrace_trap(regsize_t cause, regsize_t pc);
+
+// ktrace_read moves up to size of the oldest events to buf, going through the
+// harts in order, and returns their number.
+uint32_t ktrace_read(ktrace_event_t *buf, uint32_t size);
+
+// ktrace_dropped returns the number of events overwritten before they were
+// read, since boot.
+uint32_t ktrace_dropped();
+
+#endif // ifndef _KTRACE_H_
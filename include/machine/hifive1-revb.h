@@ -10,4 +10,12 @@
 // system cost, can be driven by a factorytrimmed on-chip oscillator."
 #define ONE_SECOND 32768
 
+// FE310 has no data cache (data lives in the DTIM scratchpad) and only a single
+// hart, so there's no false sharing to pad against. Save the RAM instead.
+#define CACHE_LINE_SIZE 4
+
+// E31 core doesn't implement the time CSR, reading it traps. Userland has to
+// make do with the coarse time snapshots in the vdso.
+#define NO_TIME_CSR 1
+
 #endif // ifndef _HIFIVE1_REVB_
@@ -0,0 +1,16 @@
+#ifndef _SPIKE_H_
+#define _SPIKE_H_
+
+// Spike's CLINT sits at the same 0x2000000 as QEMU's, and RAM starts at
+// 0x80000000 too, so only the timer and the console differ. The timer is
+// derived from the instruction count: mtime advances once every
+// INSNS_PER_RTC_TICK (100) instructions of the 1GHz CPU_HZ, see
+// riscv/platform.h in riscv-isa-sim. So this is exact, and a run under Spike
+// is fully deterministic.
+#define ONE_SECOND        (10*1000*1000)
+
+// Spike has no UART, the console and poweroff go through HTIF instead, see
+// htif.h.
+#define HTIF 1
+
+#endif // ifndef _SPIKE_H_
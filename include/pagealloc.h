@@ -5,13 +5,20 @@
 
 #define PAGE_SIZE           512 // bytes
 
-// Let's hardcode it for now. Make it small enough to fit in HiFive1 (32 pages
-// * 512 bytes = 16k RAM).
+// Default to small enough to fit in HiFive1 (32 pages * 512 bytes = 16k RAM).
+// Machines with more RAM override it on the command line.
+#ifndef MAX_PAGES
 #define MAX_PAGES           32
+#endif
 
 #define PAGE_FREE           0
 #define PAGE_ALLOCATED      1
 
+// Page allocator policies, selected at runtime with the mm.alloc_policy
+// sysctl:
+#define PAGE_ALLOC_FIRST_FIT 0 // always search from the first page
+#define PAGE_ALLOC_NEXT_FIT  1 // resume the search after the last allocation
+
 // Describes a single page of memory. Has a pointer to the actual piece of
 // memory and flags with the status.
 typedef struct page_s {
@@ -26,6 +33,9 @@ typedef struct paged_mem_s {
     page_t pages[MAX_PAGES];
     uint32_t num_pages;
 
+    // next_page is where the PAGE_ALLOC_NEXT_FIT policy starts looking
+    uint32_t next_page;
+
     // the region of unclaimed memory between stack_top and the first page
     regsize_t unclaimed_start;
     regsize_t unclaimed_end;
@@ -33,9 +43,14 @@ typedef struct paged_mem_s {
 
 // defined in pagealloc.c
 extern paged_mem_t paged_memory;
+extern uint32_t page_alloc_policy; // PAGE_ALLOC_*
 
 void init_paged_memory(void* paged_mem_end);
 void* allocate_page();
+
+// allocate_pages allocates n physically contiguous pages and returns the
+// address of the first one, or 0 if there's no long enough run of free pages.
+void* allocate_pages(uint32_t n);
 void release_page(void *ptr);
 uint32_t count_free_pages();
 void copy_page(void* dst, void* src);
@@ -0,0 +1,58 @@
+#ifndef _PERF_H_
+#define _PERF_H_
+
+#include "sys.h"
+#include "riscv.h"
+#include "syscalls.h"
+#include "proc.h"
+
+// perf virtualizes the hardware performance counters per process: the cycle,
+// instret and two mhpmcounters are read on every pass through the scheduler,
+// and whatever they advanced by since the last one is added to the process
+// that was running. When a process exits, its counts are added to its
+// parent's children counts, like rusage, so that a parent can measure a whole
+// command by forking it, see the perf program.
+//
+// The events counted by mhpmcounter3 and mhpmcounter4 are selected with the
+// perf.event3 and perf.event4 sysctls. Their values are written as is to the
+// mhpmevent CSRs, and their meaning is implementation-specific.
+//
+// instret and the hpmcounters are deliberately left out of mcounteren: read
+// directly, they'd count every process on the hart, not just the caller, so
+// U-mode has to go through perfstat(). Only cycle and time are readable, for
+// the vdso and ubench.
+
+typedef struct perf_hart_s {
+    perf_counts_t start;                // the counters at the last switch
+    uint32_t applied[PERF_NUM_HPM];     // what mhpmevent3/4 are set to
+} __attribute__((aligned(CACHE_LINE_SIZE))) perf_hart_t;
+
+typedef struct perf_s {
+    uint32_t events[PERF_NUM_HPM];      // the perf.event3/4 sysctls
+    perf_hart_t harts[MAX_HARTS];
+} perf_t;
+
+// defined in perf.c
+extern perf_t perf;
+
+void perf_init();
+
+// perf_switch is called by the scheduler whenever it's about to pick a
+// process to run. It charges last, the process that ran on this hart until
+// now, with the counts since the previous switch. last can be null, if the
+// hart was idle or the process has already been charged by perf_exit.
+void perf_switch(process_t *last);
+
+// perf_reset zeroes the counters of a new process.
+void perf_reset(process_t *proc);
+
+// perf_exit charges the exiting process with its last time slice and adds its
+// counts to the children counts of parent, unless it's null. Must be called
+// with both processes' locks held.
+void perf_exit(process_t *proc, process_t *parent);
+
+// perf_stat copies the counters of proc to stat. Must be called with
+// PROC_LOCK(proc) held.
+void perf_stat(process_t *proc, perf_stat_t *stat);
+
+#endif // ifndef _PERF_H_
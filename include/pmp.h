@@ -1,6 +1,8 @@
 #ifndef _PMP_H
 #define _PMP_H
 
+#include "sys.h"
+
 #define PMP_LOCK  (1 << 7)
 #define PMP_NAPOT (3 << 3)          // Address Mode: Naturally aligned power-of-two region, >=8 bytes
 #define PMP_NA4   (2 << 3)          // Address Mode: Naturally aligned four-byte region
@@ -13,12 +15,18 @@
 #define PMP_1     (1 << 8)          // [8..16]  2nd PMP entry in pmpcfgX register
 #define PMP_2     (1 << 16)         // [16..24] 3rd PMP entry in pmpcfgX register
 #define PMP_3     (1 << 24)         // [24..32] 4th PMP entry in pmpcfgX register
+#if XLEN == 64
+#define PMP_4     (1UL << 32)       // [32..40] 5th PMP entry in pmpcfg0 register
+#else
+#define PMP_4     (1 << 0)          // [0..8]   5th PMP entry in pmpcfg1 register
+#endif
 
 // defined in boot.s:
 extern void* user_payload;
 extern void* rodata;
 
 // defined in baremetal.ld:
+extern void* vdso_start;
 extern void* stack_bottom;
 extern void* stack_top;
 
@@ -0,0 +1,73 @@
+#ifndef _PROCFS_H_
+#define _PROCFS_H_
+
+#include "sys.h"
+#include "fs.h"
+#include "proc.h"
+#include "sysctl.h"
+
+// procfs is a synthetic filesystem mounted at /proc. Its files don't have any
+// storage, their contents are generated by a generator function when the file
+// is opened, so that a file read in several chunks is a consistent snapshot.
+// Adding a new statistic means writing a generator and listing it in
+// procfs_entries (or procfs_pid_entries, for per-process files).
+
+#define PROCFS_MOUNT_POINT "/proc/"
+
+// PROCFS_STACKS_SIZE is the largest /proc/stacks can get: two 16-byte size
+// lines, a "kstackN depth" line per hart and a "ustackPID depth" line per
+// process.
+#define PROCFS_STACKS_SIZE (2 * 16 + MAX_HARTS * 16 + MAX_PROCS * 24)
+
+// PROCFS_SYS_SIZE is the largest /proc/sys can get: a "name value" line per
+// tunable.
+#define PROCFS_SYS_SIZE (SYSCTL_MAX_ENTRIES * (SYSCTL_MAX_NAME_LEN + 12))
+
+// PROCFS_TRUNC_MARK ends a file that didn't fit its buffer.
+#define PROCFS_TRUNC_MARK "...\n"
+
+// PROCFS_MAX_NAME_LEN is the longest file name in /proc, including the
+// terminating zero.
+#define PROCFS_MAX_NAME_LEN 16
+
+// procfs_buf_t is the buffer that the generator writes the file into. It's
+// allocated from the page allocator when the file is opened, data takes up the
+// rest of its pages, and it's released when the file is closed.
+typedef struct procfs_buf_s {
+    uint32_t len;
+    uint32_t size;      // capacity of data
+    uint32_t truncated; // set if the file didn't fit and ends with PROCFS_TRUNC_MARK
+    char data[];
+} procfs_buf_t;
+
+// procfs_gen_t is a generator function: it appends the contents of the file to
+// buf. The pid is only meaningful for files under /proc/<pid>/.
+typedef void (*procfs_gen_t)(procfs_buf_t *buf, uint32_t pid);
+
+typedef struct procfs_entry_s {
+    char const *name;
+    procfs_gen_t gen;
+    uint32_t size; // the most the generator can write, or 0 if a page will do
+} procfs_entry_t;
+
+// defined in procfs.c
+extern procfs_entry_t procfs_entries[];
+extern procfs_entry_t procfs_pid_entries[];
+
+// procfs_owns_path returns true if filepath is under PROCFS_MOUNT_POINT.
+int procfs_owns_path(char const *filepath);
+
+int32_t procfs_open(file_t *f, char const *filepath, uint32_t flags);
+int32_t procfs_read(file_t *f, uint32_t pos, void *buf, uint32_t size);
+int32_t procfs_write(file_t *f, uint32_t pos, void *buf, uint32_t nbytes);
+void procfs_close(file_t *f);
+
+// Helpers for the generators. If buf fills up, they end it with
+// PROCFS_TRUNC_MARK, set buf->truncated and drop the rest of the output.
+void procfs_puts(procfs_buf_t *buf, char const *str);
+void procfs_putu(procfs_buf_t *buf, uint64_t num);
+
+// procfs_put_kv appends a "key value\n" line.
+void procfs_put_kv(procfs_buf_t *buf, char const *key, uint64_t value);
+
+#endif // ifndef _PROCFS_H_
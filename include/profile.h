@@ -0,0 +1,70 @@
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include "sys.h"
+#include "spinlock.h"
+#include "riscv.h"
+#include "syscalls.h"
+
+// profile is a sampling profiler driven by the timer interrupt. While the
+// prof.enable sysctl is on, the timer fires every prof.interval ticks instead
+// of every sched.tick, and each interrupt records where the hart was: the pc,
+// the running pid and whether it was in the kernel. The scheduler still only
+// runs once per sched.tick, the ticks in between only take a sample.
+//
+// Samples are kept in a buffer per hart and read out with the prof_read()
+// syscall; the prof program prints them, and scripts/profile.py symbolizes
+// them against the kernel ELF.
+
+// PROFILE_SAMPLES is the size of each hart's sample buffer. When a buffer is
+// full, new samples are dropped and counted until it's read out.
+#ifndef PROFILE_SAMPLES
+#define PROFILE_SAMPLES 8
+#endif
+
+// PROFILE_INTERVAL_* bound the prof.interval sysctl, in timer ticks.
+#define PROFILE_INTERVAL_DEFAULT (ONE_SECOND / 1000)
+#define PROFILE_INTERVAL_MIN     (ONE_SECOND / 10000)
+#define PROFILE_INTERVAL_MAX     ONE_SECOND
+
+typedef struct profile_buf_s {
+    uint32_t num_samples;
+    uint32_t dropped;
+    uint64_t next_sched;  // when the scheduler is due to run on this hart
+    prof_sample_t samples[PROFILE_SAMPLES];
+} __attribute__((aligned(CACHE_LINE_SIZE))) profile_buf_t;
+
+// Lock should be acquired to access the buffers.
+typedef struct profile_s {
+    spinlock lock;
+    uint32_t enable;      // the prof.enable sysctl
+    uint32_t interval;    // the prof.interval sysctl
+    uint32_t running;     // whether the buffers were reset since enabling
+    uint32_t total;       // samples taken since enabling
+    profile_buf_t harts[MAX_HARTS];
+} profile_t;
+
+// defined in profile.c
+extern profile_t profile;
+
+void profile_init();
+
+// profile_tick is called by kernel_timer_tick() on every timer interrupt,
+// with the interrupted pc. It records a sample if profiling is on, and returns
+// 1 if the interrupt was only due for the sample, in which case it has already
+// set the next timer and the scheduler should not run.
+int profile_tick(regsize_t pc, uint32_t pid, uint32_t flags);
+
+// profile_timer_interval returns the time until the next timer interrupt
+// should fire, which is the scheduler tick unless profiling needs it sooner.
+uint64_t profile_timer_interval();
+
+// profile_read moves up to size samples from the per-hart buffers to buf and
+// returns their number.
+uint32_t profile_read(prof_sample_t *buf, uint32_t size);
+
+// profile_dropped returns the number of samples dropped since profiling was
+// enabled, because a buffer was full.
+uint32_t profile_dropped();
+
+#endif // ifndef _PROFILE_H_
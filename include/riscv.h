@@ -6,6 +6,12 @@
 // An arbitrary limit, as of now:
 #define MAX_HARTS 4
 
+// CACHE_LINE_SIZE is used to align data that different harts write to, so
+// that it doesn't end up sharing a cache line. Machine headers can override it.
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
 // 1.3 Privilege Levels, Table 1.1: RISC-V privilege levels.
 #define MODE_U      0 << 11
 #define MODE_S      1 << 11
@@ -32,7 +38,17 @@ void set_pmpaddr0(void* addr);
 void set_pmpaddr1(void* addr);
 void set_pmpaddr2(void* addr);
 void set_pmpaddr3(void* addr);
+void set_pmpaddr4(void* addr);
 void set_pmpcfg0(unsigned long value);
+void set_pmpcfg1(unsigned long value); // rv32 only
+
+// 3.1.11 Counter-Enable Registers (mcounteren): when a bit is set, the
+// corresponding counter CSR can be read in the next lower privilege mode.
+#define MCOUNTEREN_CY (1 << 0) // cycle
+#define MCOUNTEREN_TM (1 << 1) // time
+#define MCOUNTEREN_IR (1 << 2) // instret
+#define MCOUNTEREN_HPM(n) (1 << (n)) // hpmcounter<n>, n is 3..31
+void set_mcounteren(unsigned int value);
 
 void set_user_mode();
 void set_jump_address(void *func);
@@ -41,7 +57,18 @@ void set_mscratch(void* ptr);
 // implemented in boot.s
 void park_hart();
 
+// num_harts is the number of harts the kernel was built for, between 1 and
+// MAX_HARTS. Only hart 0 runs kinit() to the end, the others are parked.
+// Defined in boot.s.
+extern uint32_t num_harts;
+
 void set_timer_after(uint64_t delta);
 uint64_t time_get_now();
+uint64_t get_mcycle();
+uint64_t get_minstret();
+uint64_t get_mhpmcounter3();
+uint64_t get_mhpmcounter4();
+void set_mhpmevent3(regsize_t event);
+void set_mhpmevent4(regsize_t event);
 
 #endif // ifndef _RISCV_H_
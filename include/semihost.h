@@ -0,0 +1,37 @@
+#ifndef _SEMIHOST_H_
+#define _SEMIHOST_H_
+
+#include "sys.h"
+
+// Semihosting lets the guest use the files of the host it runs on, through
+// the emulator or debugger. QEMU implements it when started with
+// -semihosting-config enable=on, see qemu-launcher.py --export-dir. A call is
+// an ebreak wrapped in a magic sequence of instructions; without semihosting,
+// that's just a breakpoint exception, so check export_state.enabled first.
+//
+// The operations and their args are described in the RISC-V Semihosting spec
+// (https://github.com/riscv-non-isa/riscv-semihosting), which reuses the ones
+// defined for ARM.
+
+#define SEMIHOST_SYS_OPEN  0x01
+#define SEMIHOST_SYS_CLOSE 0x02
+#define SEMIHOST_SYS_WRITE 0x05
+
+// SEMIHOST_MODE_WB is the SYS_OPEN mode that means fopen(name, "wb").
+#define SEMIHOST_MODE_WB 5
+
+// semihost_call makes the semihosting call op with the args block args and
+// returns what the host returned.
+regsize_t semihost_call(regsize_t op, regsize_t *args);
+
+// semihost_open opens the host file name, relative to the emulator's working
+// directory, and returns its handle or -1.
+int32_t semihost_open(char const *name, uint32_t mode);
+
+// semihost_write writes len bytes from buf to the host file fd. Returns 0 on
+// success or -1 if not everything was written.
+int32_t semihost_write(int32_t fd, void const *buf, uint32_t len);
+
+int32_t semihost_close(int32_t fd);
+
+#endif // ifndef _SEMIHOST_H_
@@ -0,0 +1,38 @@
+#ifndef _STACKMARK_H_
+#define _STACKMARK_H_
+
+#include "sys.h"
+#include "riscv.h"
+
+// Stack high-water marks: stacks are painted with STACK_PAINT when they're
+// handed out, and the deepest point a stack ever reached is found later by
+// scanning up from its bottom for the first word that isn't paint anymore.
+// That's cheap enough to do on demand, so nothing is tracked at runtime.
+//
+// A word that happens to be written with STACK_PAINT itself makes the depth
+// look smaller than it was, which is unlikely enough to not matter.
+
+// STACK_PAINT and KSTACK_SIZE, the size of each hart's kernel stack, are
+// defined in the Makefile, for boot.s to use as well. Hart N's stack ends at
+// stack_top - N * KSTACK_SIZE, both when it boots and when it takes a trap.
+#if !defined(STACK_PAINT) || !defined(KSTACK_SIZE)
+    #error STACK_PAINT and KSTACK_SIZE come from the Makefile
+#endif
+
+// stack_paint fills the stack between lo and hi with STACK_PAINT. It must
+// not be in use.
+void stack_paint(void *lo, void *hi);
+
+// stack_max_depth returns the maximum number of bytes ever used of the stack
+// between lo and hi, which must have been painted with stack_paint().
+uint32_t stack_max_depth(void *lo, void *hi);
+
+// The kernel stacks, between stack_bottom and stack_top, are painted by the
+// boot hart in boot.s before anything runs on them. The boot hart runs kinit()
+// on its kernel stack, so its depth includes that.
+
+// kstack_max_depth returns the maximum depth of hart's kernel stack, or 0 if
+// hart isn't one of the num_harts the kernel was built for.
+uint32_t kstack_max_depth(uint32_t hart);
+
+#endif // ifndef _STACKMARK_H_
@@ -0,0 +1,57 @@
+#ifndef _STRACE_H_
+#define _STRACE_H_
+
+#include "sys.h"
+#include "spinlock.h"
+#include "syscalls.h"
+#include "proc.h"
+
+// strace keeps per-syscall counters for all processes, and a log of the
+// syscalls made by the processes that have tracing enabled via the trace()
+// syscall. The log is a ring buffer shared by all traced processes: when it's
+// full, the oldest records are overwritten.
+
+// TRACE_ENTRIES is the size of the trace ring buffer, must be a power of 2.
+#ifndef TRACE_ENTRIES
+#define TRACE_ENTRIES 8
+#endif
+
+typedef struct strace_s {
+    spinlock lock;
+    trace_entry_t ring[TRACE_ENTRIES];
+    uint32_t next_seq;    // seq of the next record to be written
+    uint32_t read_seq;    // seq of the next record to be read
+    uint32_t num_traced;  // number of processes with tracing enabled
+    syscall_stat_t stats[SYS_NR_COUNT];
+} strace_t;
+
+// defined in strace.c
+extern strace_t strace;
+
+void strace_init();
+
+// strace_record is called by syscall() after every handler returns. It
+// updates the counters of syscall nr and, if the caller was traced when it
+// made the call, logs it.
+void strace_record(uint32_t pid, uint32_t traced, uint32_t nr, regsize_t *args,
+                   regsize_t ret, uint32_t cycles);
+
+// strace_enable turns tracing of proc on or off. Enabling it when no other
+// process is traced starts a new session: the ring buffer and the traced
+// counters are reset. Must be called with PROC_LOCK(proc) held.
+void strace_enable(process_t *proc, uint32_t enable);
+
+// strace_fork and strace_exit keep the count of traced processes right when
+// they come and go. Children inherit tracing from their parents.
+void strace_fork(process_t *parent, process_t *child);
+void strace_exit(process_t *proc);
+
+// strace_read moves up to size oldest records from the ring buffer to buf and
+// returns their number.
+uint32_t strace_read(trace_entry_t *buf, uint32_t size);
+
+// strace_stat copies the counters of syscall nr to stat. Returns 0 on success
+// or -1 if there's no such syscall.
+int32_t strace_stat(uint32_t nr, syscall_stat_t *stat);
+
+#endif // ifndef _STRACE_H_
@@ -1,3 +1,5 @@
+// Generated by scripts/gen-syscalls.py from src/syscalls.tbl, do not edit.
+//
 // This file is to be included both in usyscalls.S and in C code, so let's keep
 // it neat and minimal.
 
@@ -11,13 +13,24 @@
 #define SYS_NR_wait            7
 #define SYS_NR_execv          11
 #define SYS_NR_getpid         20
-
-// The numbers below differ from Linux, may need to renumber one day if we ever
-// want to achieve ABI compatibility. But for now, I don't want to make
-// trap_vector too big while very sparsely populated.
-#define SYS_NR_sysinfo        30  // __NR_sysinfo is 116 on Linux
-#define SYS_NR_sleep          31  // __NR_nanosleep is 162 on Linux
-
-// These are non-standard syscalls
+#define SYS_NR_sysinfo        30
+#define SYS_NR_sleep          31
 #define SYS_NR_plist          32
 #define SYS_NR_pinfo          33
+#define SYS_NR_psnap          34
+#define SYS_NR_sysctl         35
+#define SYS_NR_ioring_setup   36
+#define SYS_NR_ioring_enter   37
+#define SYS_NR_clock_gettime  38
+#define SYS_NR_trace          39
+#define SYS_NR_trace_read     40
+#define SYS_NR_sysstat        41
+#define SYS_NR_nop            42
+#define SYS_NR_prof_read      43
+#define SYS_NR_perfstat       44
+#define SYS_NR_ktrace_read    45
+#define SYS_NR_export         46
+#define SYS_NR_schedlat       47
+
+// SYS_NR_COUNT is the size of the syscall table: the largest number + 1
+#define SYS_NR_COUNT          48
@@ -3,13 +3,37 @@
 
 #include "sys.h"
 #include "syscallnums.h"
+#include "ioring.h"
+
+// kstat_counts_t holds the kernel event counters, as filled in by sysinfo().
+// They count since boot, and wrap around.
+typedef struct kstat_counts_s {
+    uint32_t traps;         // all exceptions, interrupts and syscalls
+    uint32_t timer_irqs;    // timer interrupts
+    uint32_t syscalls;
+    uint32_t ctx_switches;  // times the scheduler switched to another process
+    uint32_t idle;          // times a hart went idle, with nothing to run
+    uint32_t page_allocs;   // pages allocated
+    uint32_t page_frees;    // pages released
+    uint32_t fork_fails;    // fork()s that failed for lack of memory or slots
+} kstat_counts_t;
+
+// KSTAT_CPU_* are the states a hart's time is split into, indexing
+// sysinfo_t.cpu_time: running a user process, in the kernel on behalf of one
+// (syscalls and exceptions), handling interrupts, and idle, parked until the
+// next interrupt.
+#define KSTAT_CPU_USER   0
+#define KSTAT_CPU_KERNEL 1
+#define KSTAT_CPU_IRQ    2
+#define KSTAT_CPU_IDLE   3
+#define KSTAT_CPU_STATES 4
 
 // Notes:
 // * xxxxram numbers are in pages, multiply them by PAGE_SIZE to get bytes
 // * the commented fields are not (yet?) implemented, uncomment them as we go
 typedef struct sysinfo_s {
-    // uint32_t uptime;             // Seconds since boot
-    // uint32_t loads[3];  // 1, 5, and 15 minute load averages
+    uint32_t uptime;    // Seconds since boot
+    uint32_t loads[3];  // 1, 5, and 15 minute load averages, see SI_LOAD_SHIFT
     uint32_t totalram;  // Total usable main memory size
     uint32_t freeram;   // Available memory size
     // uint32_t sharedram; // Amount of shared memory
@@ -21,14 +45,45 @@ typedef struct sysinfo_s {
     // the region of unclaimed memory between stack_top and the first page
     regsize_t unclaimed_start;
     regsize_t unclaimed_end;
+
+    // the kernel event counters, and the time spent in each KSTAT_CPU_*
+    // state in timer ticks, both summed over all harts. cpu_harts is the
+    // number of harts the times cover. vdso_sysinfo() doesn't fill them in.
+    kstat_counts_t kstat;
+    uint64_t cpu_time[KSTAT_CPU_STATES];
+    uint32_t cpu_harts;
 } sysinfo_t;
 
+// sysinfo_t.loads are fixed-point numbers with SI_LOAD_SHIFT fractional bits,
+// like on Linux.
+#define SI_LOAD_SHIFT 16
+
+#define CLOCK_MONOTONIC 1 // time since boot
+
+typedef struct timespec_s {
+    uint64_t tv_sec;
+    uint32_t tv_nsec;
+} timespec_t;
+
 typedef struct pinfo_s {
     uint32_t pid;
     char name[16];
     uint32_t state;
+    uint32_t stack_max;    // deepest the stack has ever been, in bytes
 } pinfo_t;
 
+// pstat_t is a snapshot of a single process, as filled in by psnap().
+typedef struct pstat_s {
+    uint32_t pid;
+    uint32_t ppid;         // pid of the parent, or 0 if there's none
+    uint32_t state;        // PROC_STATE_*
+    uint32_t pages;        // number of memory pages owned by the process
+    uint64_t cpu_time;     // time spent running, in timer ticks
+    uint64_t wakeup_time;  // timer value to wake up at, if sleeping
+    uint32_t stack_max;    // deepest the stack has ever been, in bytes
+    char name[16];
+} pstat_t;
+
 #define DIRENT_READABLE   (1 << 0)
 #define DIRENT_WRITABLE   (1 << 1)
 #define DIRENT_EXECUTABLE (1 << 2)
@@ -43,20 +98,100 @@ typedef struct dirent_s {
     char name[MAX_FILENAME_LEN];
 } dirent_t;
 
-void sys_restart();
-void sys_exit();
-uint32_t sys_fork();
-int32_t sys_read();
-int32_t sys_write();
-int32_t sys_open();
-int32_t sys_close();
-int32_t sys_wait();
-uint32_t sys_execv();
-uint32_t sys_getpid();
-uint32_t sys_sysinfo();
-uint32_t sys_sleep();
-uint32_t sys_plist();
-uint32_t sys_pinfo();
+// trace_entry_t is a record of a single syscall made by a traced process, as
+// returned by trace_read(). seq numbers the records consecutively since
+// tracing was enabled, so a gap in them means that the trace buffer was full
+// and older records were dropped.
+typedef struct trace_entry_s {
+    uint32_t seq;
+    uint32_t pid;
+    uint32_t nr;          // SYS_NR_*
+    uint32_t nargs;       // number of meaningful args
+    regsize_t args[6];    // raw values of a0..a5
+    regsize_t ret;        // raw value returned in a0
+    uint32_t cycles;      // cycles spent in the kernel handler
+} trace_entry_t;
+
+// syscall_stat_t holds the counters of a single syscall, as filled in by
+// sysstat(). count and cycles are kept for all processes since boot, while
+// traced_count and traced_cycles only count the calls made by traced
+// processes, since tracing was last enabled.
+typedef struct syscall_stat_s {
+    uint32_t count;
+    uint32_t traced_count;
+    uint64_t cycles;
+    uint64_t traced_cycles;
+} syscall_stat_t;
+
+// prof_sample_t is a single sample taken by the profiler on a timer
+// interrupt, as returned by prof_read(). pc is where the hart was interrupted,
+// pid is the process that was running there, or -1 if the hart was idle.
+typedef struct prof_sample_s {
+    regsize_t pc;
+    uint32_t pid;
+    uint32_t hart;
+    uint32_t flags;       // PROF_SAMPLE_*
+} prof_sample_t;
+
+#define PROF_SAMPLE_KERNEL (1 << 0) // the interrupt came from M-mode
+#define PROF_SAMPLE_IDLE   (1 << 1) // the hart had nothing to run
+
+// ktrace_event_t is a single kernel trace event, as returned by ktrace_read().
+// The meaning of the args depends on the event, see KTRACE_EV_* in ktrace.h.
+typedef struct ktrace_event_s {
+    uint64_t time;      // timer value when the event happened
+    uint32_t event;     // KTRACE_EV_*
+    uint32_t hart;
+    uint32_t args[2];
+} ktrace_event_t;
+
+// EXPORT_* are the kinds of data that export() can write to the host, and
+// the flags it takes, see export.h.
+#define EXPORT_KTRACE  0 // the kernel trace events, to ktrace.bin
+#define EXPORT_PROFILE 1 // the profiler samples, to profile.bin
+
+#define EXPORT_CLOSE (1 << 0) // close the file after writing
+
+// SCHEDLAT_BUCKETS is the number of buckets in schedlat_t.buckets. The last
+// one also counts all delays above its range.
+#define SCHEDLAT_BUCKETS 24
+
+// SCHEDLAT_ALL can be passed to schedlat() instead of a pid, to get the
+// histogram of all processes.
+#define SCHEDLAT_ALL ((uint32_t)-1)
+
+// schedlat_t is a histogram of scheduling latencies, as filled in by
+// schedlat(): how long processes waited between becoming runnable and
+// actually running, in microseconds. buckets[0] counts delays below 1us, and
+// buckets[i] those in [2^(i-1), 2^i) us.
+typedef struct schedlat_s {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[SCHEDLAT_BUCKETS];
+} schedlat_t;
+
+// PERF_NUM_HPM is the number of programmable event counters that the kernel
+// keeps per process: mhpmcounter3 and mhpmcounter4. The events they count are
+// selected with the perf.event3 and perf.event4 sysctls.
+#define PERF_NUM_HPM 2
+
+// perf_counts_t holds the hardware counters accumulated by a process while it
+// was running.
+typedef struct perf_counts_s {
+    uint64_t cycles;
+    uint64_t instret;
+    uint64_t hpm[PERF_NUM_HPM];
+} perf_counts_t;
+
+// perf_stat_t is filled in by perfstat(). self counts the process itself,
+// children counts all of its descendants that have exited.
+typedef struct perf_stat_s {
+    perf_counts_t self;
+    perf_counts_t children;
+} perf_stat_t;
+
+#include "syscalltable.h"
 
 // These are implemented in assembler as of now:
 extern void poweroff();
@@ -0,0 +1,51 @@
+// Generated by scripts/gen-syscalls.py from src/syscalls.tbl, do not edit.
+
+#ifndef _SYSCALLTABLE_H_
+#define _SYSCALLTABLE_H_
+
+// syscall_fn_t is the type of syscall_vector entries. They take the raw values
+// of a0..a5 and return the value for a0.
+typedef regsize_t (*syscall_fn_t)(regsize_t a0, regsize_t a1, regsize_t a2,
+                                  regsize_t a3, regsize_t a4, regsize_t a5);
+
+// syscall_info_t describes a syscall, e.g. for tracing.
+typedef struct syscall_info_s {
+    char const *name;
+    uint32_t nargs;
+} syscall_info_t;
+
+// defined in syscalltable.c
+extern syscall_fn_t syscall_vector[SYS_NR_COUNT];
+extern syscall_info_t syscall_info[SYS_NR_COUNT];
+
+// the handlers, implemented in syscalls.c
+void sys_restart();
+void sys_exit(int32_t code);
+uint32_t sys_fork();
+int32_t sys_read(uint32_t fd, char *buf, uint32_t size);
+int32_t sys_write(uint32_t fd, char const *data, uint32_t size);
+int32_t sys_open(char const *filepath, uint32_t flags);
+int32_t sys_close(uint32_t fd);
+int32_t sys_wait();
+uint32_t sys_execv(char const *filename, char const **argv);
+uint32_t sys_getpid();
+uint32_t sys_sysinfo(sysinfo_t *info);
+uint32_t sys_sleep(uint64_t milliseconds);
+uint32_t sys_plist(uint32_t *pids, uint32_t size);
+uint32_t sys_pinfo(uint32_t pid, pinfo_t *pinfo);
+uint32_t sys_psnap(pstat_t *buf, uint32_t size, uint32_t skip);
+int32_t sys_sysctl(char const *name, uint32_t *oldval, uint32_t const *newval);
+int32_t sys_ioring_setup(ioring_t *ring);
+int32_t sys_ioring_enter();
+int32_t sys_clock_gettime(uint32_t clock_id, timespec_t *tp);
+int32_t sys_trace(uint32_t pid, uint32_t enable);
+uint32_t sys_trace_read(trace_entry_t *buf, uint32_t size);
+int32_t sys_sysstat(uint32_t nr, syscall_stat_t *stat);
+int32_t sys_nop();
+uint32_t sys_prof_read(prof_sample_t *buf, uint32_t size);
+int32_t sys_perfstat(uint32_t pid, perf_stat_t *stat);
+uint32_t sys_ktrace_read(ktrace_event_t *buf, uint32_t size);
+int32_t sys_export(uint32_t kind, uint32_t flags);
+int32_t sys_schedlat(uint32_t pid, schedlat_t *lat);
+
+#endif // ifndef _SYSCALLTABLE_H_
@@ -0,0 +1,62 @@
+#ifndef _SYSCTL_H_
+#define _SYSCTL_H_
+
+#include "sys.h"
+#include "spinlock.h"
+
+// sysctl is a registry of runtime kernel tunables. A subsystem registers a
+// tunable during its init, pointing at the variable that it reads the setting
+// from. After that, the value can be read and changed at runtime via the
+// sysctl() syscall, listed in /proc/sys, or preset on boot with a name=value
+// word in FDT bootargs.
+
+// SYSCTL_MAX_ENTRIES is the maximum number of registered tunables.
+#define SYSCTL_MAX_ENTRIES 16
+
+// SYSCTL_MAX_NAME_LEN is the longest tunable name, including the terminating
+// zero.
+#define SYSCTL_MAX_NAME_LEN 24
+
+#define SYSCTL_TYPE_UINT 0 // an unsigned 32-bit number in range [min, max]
+#define SYSCTL_TYPE_BOOL 1 // 0 or 1, min and max are ignored
+
+typedef struct sysctl_s {
+    char const *name;
+    uint32_t type;      // SYSCTL_TYPE_*
+    uint32_t *value;    // the variable that the owning subsystem reads
+    uint32_t min;
+    uint32_t max;
+} sysctl_t;
+
+// Contains all registered tunables. Lock should be acquired to access
+// anything in this struct.
+typedef struct sysctl_table_s {
+    spinlock lock;
+    sysctl_t entries[SYSCTL_MAX_ENTRIES];
+    uint32_t num_entries;
+} sysctl_table_t;
+
+// defined in sysctl.c
+extern sysctl_table_t sysctl_table;
+
+void sysctl_init();
+
+// sysctl_register adds a new tunable to the registry. Returns 0 on success or
+// -1 if the registry is full.
+int32_t sysctl_register(char const *name, uint32_t type, uint32_t *value,
+                        uint32_t min, uint32_t max);
+
+// sysctl_get reads the value of the named tunable into *value. Returns 0 on
+// success or -1 if there's no such tunable.
+int32_t sysctl_get(char const *name, uint32_t *value);
+
+// sysctl_set changes the value of the named tunable. Returns 0 on success or
+// -1 if there's no such tunable or the value is out of its range.
+int32_t sysctl_set(char const *name, uint32_t value);
+
+// sysctl_apply_bootargs looks for name=value words in bootargs and sets the
+// corresponding tunables. Unknown names and bad values are reported and
+// skipped.
+void sysctl_apply_bootargs(char const *bootargs);
+
+#endif // ifndef _SYSCTL_H_
@@ -10,10 +10,39 @@ extern void push_pop_stack();
 extern int *a_string_in_user_mem_ptr;
 extern int *msg_m_hello_ptr;
 
+// defined in userland.c
+extern int _userland ustrncmp(char const *a, char const *b, unsigned int num);
+extern uint64_t _userland uudiv64(uint64_t n, uint32_t d);
+extern int _userland uatou(char const *s, uint32_t *val);
+
+// spawn forks a child that runs the program name, and returns its pid, or -1.
+// wait_gone polls until process pid has exited, calling poll(arg) as it goes.
+extern uint32_t _userland spawn(char const *name, char const *argv[], int traced);
+extern void _userland wait_gone(uint32_t pid, uint32_t poll_ms,
+                                void (*poll)(void *arg), void *arg);
+
+// ulat_add counts a latency of us microseconds in lat, the way the kernel
+// does for schedlat(), and print_lat_hist prints lat as a histogram.
+extern void _userland ulat_add(schedlat_t *lat, uint32_t us);
+extern void _userland print_lat_hist(schedlat_t *lat);
+
 // defined in user-printf.s
 extern int32_t _userland printf(char const* fmt, ...);
 
 // defined in user-printf.c
 extern int32_t _userland prints(char const* str);
 
+// defined in usyscallnames.c, indexed by SYS_NR_*. Holes in the syscall
+// numbers are null.
+extern char *usyscall_names[SYS_NR_COUNT];
+
+// defined in user-vdso.c, these read the vdso (see vdso.h) without trapping:
+extern uint32_t _userland vdso_getpid();
+extern uint32_t _userland vdso_timebase_freq(); // vdso_time() ticks per second
+extern uint64_t _userland vdso_time();
+extern uint64_t _userland vdso_uptime(); // in vdso_time() ticks
+
+// vdso_sysinfo fills in the totalram, freeram and procs fields of info.
+extern void _userland vdso_sysinfo(sysinfo_t *info);
+
 #endif // ifndef _USERLAND_H_
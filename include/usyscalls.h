@@ -1,29 +1,110 @@
+// Generated by scripts/gen-syscalls.py from src/syscalls.tbl, do not edit.
+
 #ifndef _USYSCALLS_H_
 #define _USYSCALLS_H_
 
 #include "syscalls.h"
 
 // Declarations for userland end of the system calls. Implemented in
-// usyscalls.s.
+// usyscalls.S.
 
-extern void exit();
+extern void restart();
+extern void exit(int32_t code);
 extern uint32_t fork();
-extern int32_t read(uint32_t fd, char* buf, uint32_t size);
+extern int32_t read(uint32_t fd, char *buf, uint32_t size);
 
 // write writes the given data to file descriptor fd. The two special file
 // descriptors are stdout=1 and stderr=2. Other descriptors should be obtained
 // via open(). The size parameter is optional: it specifies how many bytes to
 // write from data, but it can be -1 if data contains a zero-terminated string,
 // then data will be written until the first zero byte is encountered.
-extern int32_t write(uint32_t fd, char const* data, uint32_t size);
+extern int32_t write(uint32_t fd, char const *data, uint32_t size);
+
 extern int32_t open(char const *filepath, uint32_t flags);
 extern int32_t close(uint32_t fd);
 extern int32_t wait();
-extern uint32_t execv(char const* filename, char const* argv[]);
+extern uint32_t execv(char const *filename, char const **argv);
 extern uint32_t getpid();
-extern uint32_t sysinfo(sysinfo_t* info);
+extern uint32_t sysinfo(sysinfo_t *info);
 extern uint32_t sleep(uint64_t milliseconds);
 extern uint32_t plist(uint32_t *pids, uint32_t size);
 extern uint32_t pinfo(uint32_t pid, pinfo_t *pinfo);
 
+// psnap takes a snapshot of up to size processes into buf, skipping the first
+// skip of them. Returns the total number of processes, which can be larger
+// than size, in which case the caller can call it again with a bigger skip to
+// get the rest.
+extern uint32_t psnap(pstat_t *buf, uint32_t size, uint32_t skip);
+
+// sysctl reads and/or changes the kernel tunable called name. If oldval is
+// not null, the current value is stored there. Then, if newval is not null,
+// the tunable is set to *newval. Returns 0 on success or -1 if there's no such
+// tunable or the new value is out of its range. All tunables are listed in
+// /proc/sys.
+extern int32_t sysctl(char const *name, uint32_t *oldval, uint32_t const *newval);
+
+// ioring_setup registers ring as the process's ioring (see ioring.h), or
+// unregisters it if ring is null. The ring has to be in the process's stack
+// and stay there while it's registered, so unregister it before returning from
+// the function that owns it. Returns 0 on success, or -1 if ring is not in
+// the stack.
+extern int32_t ioring_setup(ioring_t *ring);
+
+// ioring_enter executes all pending submissions in the process's ioring, until
+// the completion ring fills up. If a sleep is among them, the process sleeps
+// after completing it, and the submissions after it stay pending. Returns the
+// number of executed submissions, or -1 if there's no ioring.
+extern int32_t ioring_enter();
+
+// clock_gettime stores the current time of the given clock in tp. Only
+// CLOCK_MONOTONIC, the time since boot, is supported. Returns 0 on success or
+// -1 if the clock is not supported. See also vdso_time(), which is cheaper.
+extern int32_t clock_gettime(uint32_t clock_id, timespec_t *tp);
+
+// trace turns the tracing of process pid on (enable != 0) or off. Pid 0 means
+// the calling process. The syscalls of traced processes are logged into the
+// kernel's trace buffer, and their children are traced too. Enabling it when
+// no other process is traced clears the buffer and the traced counters of
+// sysstat(). Returns 0 on success or -1 if there's no such process.
+extern int32_t trace(uint32_t pid, uint32_t enable);
+
+// trace_read moves up to size oldest records from the trace buffer to buf.
+// Returns their number, 0 if the buffer is empty.
+extern uint32_t trace_read(trace_entry_t *buf, uint32_t size);
+
+// sysstat fills stat with the call counters of syscall nr, see
+// syscall_stat_t. Returns 0 on success or -1 if there's no such syscall.
+extern int32_t sysstat(uint32_t nr, syscall_stat_t *stat);
+
+// nop does nothing and returns 0. It's there to measure the bare cost of a
+// syscall, see ubench.
+extern int32_t nop();
+
+// prof_read moves up to size samples taken by the profiler to buf and returns
+// their number. The profiler is turned on with the prof.enable sysctl, see
+// profile.h.
+extern uint32_t prof_read(prof_sample_t *buf, uint32_t size);
+
+// perfstat fills stat with the hardware counters of process pid (or of the
+// calling process if pid is 0), see perf_stat_t. Returns 0 on success or -1 if
+// there's no such process.
+extern int32_t perfstat(uint32_t pid, perf_stat_t *stat);
+
+// ktrace_read moves up to size of the oldest kernel trace events to buf and
+// returns their number. Tracing is turned on with the ktrace.enable sysctl, see
+// ktrace.h.
+extern uint32_t ktrace_read(ktrace_event_t *buf, uint32_t size);
+
+// export moves the buffered data of kind (one of EXPORT_*) straight to a file
+// on the host, via semihosting. The file is created on the first call, and
+// kept open for the following ones until one passes EXPORT_CLOSE in flags.
+// Returns the number of records written, or -1 if the kernel wasn't booted
+// with export on, see export.h.
+extern int32_t export(uint32_t kind, uint32_t flags);
+
+// schedlat fills lat with the scheduling latency histogram of process pid (or
+// of the calling process if pid is 0), or of all processes since boot if pid
+// is SCHEDLAT_ALL. Returns 0 on success or -1 if there's no such process.
+extern int32_t schedlat(uint32_t pid, schedlat_t *lat);
+
 #endif // ifndef _USYSCALLS_H_
@@ -0,0 +1,48 @@
+#ifndef _VDSO_H_
+#define _VDSO_H_
+
+#include "sys.h"
+
+// The vdso is a small data area that the kernel keeps up to date and userland
+// can read, but not write: it's in a PMP region of its own, see init_pmp(). It
+// lets programs get the time, their pid and a few basic stats with a couple of
+// loads instead of an ecall.
+//
+// The kernel updates it under a seqlock: seq is odd while an update is in
+// progress and is incremented again when it's done. Readers should use the
+// helpers in user-vdso.c, which retry until they see the same even seq before
+// and after reading.
+
+#define _vdso __attribute__((__section__(".vdso")))
+
+typedef struct vdso_data_s {
+    volatile uint32_t seq;
+    uint32_t timebase_freq; // timer ticks per second
+    uint64_t boot_time;     // timer value at boot
+    uint64_t tick_time;     // timer value at the latest process switch or tick
+    uint32_t pid;           // pid of the running process
+    uint32_t procs;         // number of processes
+    uint32_t totalram;      // total number of pages
+    uint32_t freeram;       // number of free pages
+    uint32_t switches;      // number of context switches since boot
+} vdso_data_t;
+
+// defined in vdso.c
+extern vdso_data_t vdso_data;
+
+// defined in baremetal.ld
+extern void* vdso_start;
+
+void vdso_init();
+
+// vdso_begin_write and vdso_end_write bracket every update of vdso_data.
+void vdso_begin_write();
+void vdso_end_write();
+
+// Shorthands for the updates that the rest of the kernel makes:
+void vdso_set_running(uint32_t pid, uint64_t now);
+void vdso_set_procs(uint32_t procs);
+void vdso_set_ram(uint32_t totalram, uint32_t freeram);
+void vdso_add_freeram(int32_t delta);
+
+#endif // ifndef _VDSO_H_
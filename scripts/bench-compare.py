@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+
+# pylint: disable=invalid-name,missing-function-docstring
+
+"""Compares two sets of benchmark results, from 'make bench', 'make kbench' or
+'make host-bench'.
+
+Usage: bench-compare.py OLD NEW
+
+OLD and NEW are either single result files (out/bench-<binary>.txt,
+out/kbench-<binary>.txt or out/hbench-host.txt), or directories with such
+files, in which case the files with the same name are compared. For example:
+
+    make bench && cp -r out bench-before
+    ... change things ...
+    make bench && ./scripts/bench-compare.py bench-before out
+
+Prints the cycles per operation of every benchmark in both (the median for
+kbench, and nanoseconds for hbench), and the change in percent. Exits with status 1 if any benchmark got
+slower by more than the --threshold percentage, so that it can be used in
+scripts.
+"""
+
+import argparse
+import glob
+import os
+import sys
+
+
+def parse(path):
+    """Returns a dict of benchmark name to cycles per op. The lines are either
+    'bench <name> <ops> <cycles/op> <ns/op>', or
+    '[kh]bench <name> <min> <median> <max>'."""
+    results = {}
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) != 5 or fields[0] not in ('bench', 'kbench', 'hbench'):
+                continue
+            results[fields[1]] = int(fields[3])
+    return results
+
+
+def pairs(old, new):
+    if not os.path.isdir(old):
+        return [(os.path.basename(new), old, new)]
+    out = []
+    for path in sorted(glob.glob(os.path.join(old, '*bench-*.txt'))):
+        name = os.path.basename(path)
+        other = os.path.join(new, name)
+        if os.path.exists(other):
+            out.append((name, path, other))
+    return out
+
+
+def change(old, new):
+    if old == 0:
+        return 0.0
+    return (new - old) * 100.0 / old
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('old', help='baseline results, a file or a directory')
+    parser.add_argument('new', help='new results, a file or a directory')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='report slowdowns above this many percent')
+    args = parser.parse_args()
+    regressions = 0
+    for title, old_path, new_path in pairs(args.old, args.new):
+        old, new = parse(old_path), parse(new_path)
+        print(title)
+        print('  %-24s %12s %12s %8s' % ('benchmark', 'old cyc/op',
+                                         'new cyc/op', 'change'))
+        for name in sorted(set(old) | set(new)):
+            if name not in old or name not in new:
+                print('  %-24s %s' % (name, 'only in old' if name in old
+                                      else 'only in new'))
+                continue
+            delta = change(old[name], new[name])
+            mark = ''
+            if delta > args.threshold:
+                mark = '  <-- slower'
+                regressions += 1
+            print('  %-24s %12d %12d %+7.1f%%%s' % (name, old[name], new[name],
+                                                    delta, mark))
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -3,6 +3,7 @@
 cd riscv-isa-sim
 mkdir -p build
 cd build
-../configure --prefix=$(readlink -m ./build/) --target=riscv64-unknown-linux-gnu
+../configure --prefix=$(readlink -m ./build/) --target=riscv64-unknown-linux-gnu \
+    --enable-histogram
 make
 make install
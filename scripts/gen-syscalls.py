@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+
+# pylint: disable=invalid-name,missing-function-docstring
+
+"""Generates all the syscall boilerplate from the syscall table.
+
+Usage: gen-syscalls.py [src/syscalls.tbl]
+
+See the top of src/syscalls.tbl for the format. The outputs are written
+relative to the repository root:
+
+    include/syscallnums.h   SYS_NR_* numbers, for both C and assembly
+    include/syscalltable.h  kernel handler prototypes and the table types
+    src/syscalltable.c      the dispatch table, arg unpacking and metadata
+    src/usyscalls.S         userland stubs
+    include/usyscalls.h     userland declarations
+    src/usyscallnames.c     syscall names for userland, e.g. for strace
+"""
+
+import os
+import re
+import sys
+
+
+MAX_ARG_REGS = 6  # a0..a5
+WIDE_TYPES = ('uint64_t', 'int64_t')
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+GENERATED_NOTE = ('Generated by scripts/gen-syscalls.py from src/syscalls.tbl, '
+                  'do not edit.')
+
+LINE_RE = re.compile(r'^(\d+)\s+(.+?)\s*\b(\w+)\((.*)\)$')
+ARG_RE = re.compile(r'^(.*?)\s*(\w+)$')
+
+
+class Syscall:
+    def __init__(self, nr, ret, name, args, doc):
+        self.nr = nr
+        self.ret = ret
+        self.name = name
+        self.args = args  # list of (type, name)
+        self.doc = doc
+
+    def params(self):
+        if not self.args:
+            return ''
+        return ', '.join(join_type(t, n) for t, n in self.args)
+
+    def nregs(self, xlen):
+        return sum(arg_regs(t, xlen) for t, _ in self.args)
+
+
+def join_type(typ, name):
+    if typ.endswith('*'):
+        return typ + name
+    return typ + ' ' + name
+
+
+def arg_regs(typ, xlen):
+    if xlen == 32 and typ in WIDE_TYPES:
+        return 2
+    return 1
+
+
+def fail(path, lineno, msg):
+    sys.exit('%s:%d: %s' % (path, lineno, msg))
+
+
+def parse(path):
+    syscalls = []
+    doc = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.strip()
+            if not line:
+                doc = []
+                continue
+            if line.startswith('#'):
+                continue
+            if line.startswith('//'):
+                doc.append(line)
+                continue
+            m = LINE_RE.match(line)
+            if not m:
+                fail(path, lineno, 'bad syscall line: ' + line)
+            nr, ret, name, argstr = m.groups()
+            args = []
+            for arg in filter(None, (a.strip() for a in argstr.split(','))):
+                am = ARG_RE.match(arg)
+                if not am or not am.group(1):
+                    fail(path, lineno, 'bad argument: ' + arg)
+                args.append((am.group(1), am.group(2)))
+            sc = Syscall(int(nr), ret, name, args, doc)
+            if ret in WIDE_TYPES:
+                fail(path, lineno, '64-bit return values are not supported')
+            if sc.nregs(32) > MAX_ARG_REGS:
+                fail(path, lineno, 'too many arguments for a0..a5')
+            if any(s.nr == sc.nr or s.name == sc.name for s in syscalls):
+                fail(path, lineno, 'duplicate syscall: ' + line)
+            syscalls.append(sc)
+            doc = []
+    return syscalls
+
+
+def write(relpath, text):
+    with open(os.path.join(ROOT, relpath), 'w') as f:
+        f.write(text)
+
+
+def gen_syscallnums(syscalls):
+    out = ['// ' + GENERATED_NOTE,
+           '//',
+           '// This file is to be included both in usyscalls.S and in C code, '
+           'so let\'s keep',
+           '// it neat and minimal.',
+           '']
+    for sc in syscalls:
+        out.append('#define %-20s %3d' % ('SYS_NR_' + sc.name, sc.nr))
+    out.append('')
+    out.append('// SYS_NR_COUNT is the size of the syscall table: the largest '
+               'number + 1')
+    out.append('#define %-20s %3d' % ('SYS_NR_COUNT',
+                                    max(sc.nr for sc in syscalls) + 1))
+    return '\n'.join(out) + '\n'
+
+
+def gen_syscalltable_h(syscalls):
+    out = ['// ' + GENERATED_NOTE,
+           '',
+           '#ifndef _SYSCALLTABLE_H_',
+           '#define _SYSCALLTABLE_H_',
+           '',
+           '// syscall_fn_t is the type of syscall_vector entries. They take '
+           'the raw values',
+           '// of a0..a5 and return the value for a0.',
+           'typedef regsize_t (*syscall_fn_t)(regsize_t a0, regsize_t a1, '
+           'regsize_t a2,',
+           '                                  regsize_t a3, regsize_t a4, '
+           'regsize_t a5);',
+           '',
+           '// syscall_info_t describes a syscall, e.g. for tracing.',
+           'typedef struct syscall_info_s {',
+           '    char const *name;',
+           '    uint32_t nargs;',
+           '} syscall_info_t;',
+           '',
+           '// defined in syscalltable.c',
+           'extern syscall_fn_t syscall_vector[SYS_NR_COUNT];',
+           'extern syscall_info_t syscall_info[SYS_NR_COUNT];',
+           '',
+           '// the handlers, implemented in syscalls.c']
+    for sc in syscalls:
+        out.append('%s sys_%s(%s);' % (sc.ret, sc.name, sc.params()))
+    out.append('')
+    out.append('#endif // ifndef _SYSCALLTABLE_H_')
+    return '\n'.join(out) + '\n'
+
+
+def unpack_args(sc, xlen):
+    exprs = []
+    reg = 0
+    for typ, _ in sc.args:
+        if arg_regs(typ, xlen) == 2:
+            exprs.append('(%s)((uint64_t)a%d | (uint64_t)a%d << 32)'
+                         % (typ, reg, reg + 1))
+            reg += 2
+        else:
+            exprs.append('(%s)a%d' % (typ, reg))
+            reg += 1
+    return ', '.join(exprs)
+
+
+def gen_call(sc, xlen):
+    call = 'sys_%s(%s)' % (sc.name, unpack_args(sc, xlen))
+    if sc.ret == 'void':
+        return ['    %s;' % call, '    return 0;']
+    # 32-bit values are kept sign-extended in registers on rv64, regardless
+    # of their signedness:
+    return ['    return (regsize_t)(int32_t)%s;' % call]
+
+
+def gen_syscalltable_c(syscalls):
+    out = ['// ' + GENERATED_NOTE,
+           '',
+           '#include "syscalls.h"',
+           '',
+           '// The syscall_*() functions unpack the raw register values into '
+           'the typed',
+           '// arguments of their handlers.']
+    for sc in syscalls:
+        out.append('')
+        out.append('regsize_t syscall_%s(regsize_t a0, regsize_t a1, '
+                   'regsize_t a2,' % sc.name)
+        out.append('        regsize_t a3, regsize_t a4, regsize_t a5) {')
+        call32 = gen_call(sc, 32)
+        call64 = gen_call(sc, 64)
+        if call32 == call64:
+            out.extend(call64)
+        else:
+            out.append('#if XLEN == 32')
+            out.extend(call32)
+            out.append('#else')
+            out.extend(call64)
+            out.append('#endif')
+        out.append('}')
+    out.append('')
+    out.append('// Note that we place syscall_vector in a .text segment in order '
+               'to have it in')
+    out.append('// ROM, since it\'s read-only after all.')
+    out.append('syscall_fn_t syscall_vector[SYS_NR_COUNT] _text = {')
+    for sc in syscalls:
+        out.append('    %-20s syscall_%s,' % ('[SYS_NR_%s]' % sc.name, sc.name))
+    out.append('};')
+    out.append('')
+    out.append('syscall_info_t syscall_info[SYS_NR_COUNT] _rodata = {')
+    for sc in syscalls:
+        out.append('    %-20s { .name = "%s", .nargs = %d },'
+                   % ('[SYS_NR_%s]' % sc.name, sc.name, len(sc.args)))
+    out.append('};')
+    return '\n'.join(out) + '\n'
+
+
+def gen_usyscalls_s(syscalls):
+    out = ['// ' + GENERATED_NOTE,
+           '',
+           '.include "src/machine-word.inc"',
+           '#include "syscallnums.h"',
+           '',
+           '.macro  macro_syscall nr',
+           '        li      a7, \\nr                 # for fun let\'s pretend '
+           'syscall is kinda like Linux: syscall nr in a7, other arguments in '
+           'a0..a5',
+           '        ecall',
+           '.endm',
+           '',
+           '.balign 4',
+           '.section .user_text']
+    for sc in syscalls:
+        out.append('.globl %s' % sc.name)
+        out.append('%s:' % sc.name)
+        out.append('        macro_syscall SYS_NR_%s' % sc.name)
+        out.append('        ret')
+        out.append('')
+    return '\n'.join(out)
+
+
+def gen_usyscalls_h(syscalls):
+    out = ['// ' + GENERATED_NOTE,
+           '',
+           '#ifndef _USYSCALLS_H_',
+           '#define _USYSCALLS_H_',
+           '',
+           '#include "syscalls.h"',
+           '',
+           '// Declarations for userland end of the system calls. Implemented '
+           'in',
+           '// usyscalls.S.',
+           '']
+    for sc in syscalls:
+        if sc.doc:
+            if out[-1] != '':
+                out.append('')
+            out.extend(sc.doc)
+        out.append('extern %s %s(%s);' % (sc.ret, sc.name, sc.params()))
+        if sc.doc:
+            out.append('')
+    if out[-1] != '':
+        out.append('')
+    out.append('#endif // ifndef _USYSCALLS_H_')
+    return '\n'.join(out) + '\n'
+
+
+def gen_usyscallnames_c(syscalls):
+    out = ['// ' + GENERATED_NOTE,
+           '',
+           '#include "userland.h"',
+           '',
+           '// The names are in user memory, unlike syscall_info, so that '
+           'userland can',
+           '// print them, e.g. in strace.']
+    for sc in syscalls:
+        out.append('char usyscall_name_%s[] _user_rodata = "%s";'
+                   % (sc.name, sc.name))
+    out.append('')
+    out.append('char *usyscall_names[SYS_NR_COUNT] _user_rodata = {')
+    for sc in syscalls:
+        out.append('    %-20s usyscall_name_%s,'
+                   % ('[SYS_NR_%s]' % sc.name, sc.name))
+    out.append('};')
+    return '\n'.join(out) + '\n'
+
+
+def main():
+    table = sys.argv[1] if len(sys.argv) > 1 else os.path.join(ROOT, 'src',
+                                                               'syscalls.tbl')
+    syscalls = sorted(parse(table), key=lambda sc: sc.nr)
+    write('include/syscallnums.h', gen_syscallnums(syscalls))
+    write('include/syscalltable.h', gen_syscalltable_h(syscalls))
+    write('src/syscalltable.c', gen_syscalltable_c(syscalls))
+    write('src/usyscalls.S', gen_usyscalls_s(syscalls))
+    write('include/usyscalls.h', gen_usyscalls_h(syscalls))
+    write('src/usyscallnames.c', gen_usyscallnames_c(syscalls))
+
+
+if __name__ == '__main__':
+    main()
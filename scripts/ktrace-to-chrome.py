@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+
+# pylint: disable=invalid-name,missing-function-docstring
+
+"""Converts the output of the ktrace program to the Chrome trace event format,
+which can be opened in Perfetto (https://ui.perfetto.dev) or chrome://tracing.
+
+Usage: ktrace-to-chrome.py KTRACE_LOG [-o OUT.json]
+
+KTRACE_LOG is the console output with the ktrace lines, see u_main_ktrace,
+or the ktrace.bin it exported with qemu-launcher.py --export-dir.
+Each hart gets two tracks: one with the processes that ran on it and the
+instant events (wakeups, timer interrupts, traps, page allocations, forks
+and exits), and one with the syscalls. 'make ktrace' does all of this for a
+run of ubench.
+
+The event numbers are parsed from include/ktrace.h and the syscall names
+from src/syscalls.tbl, so that they can't get out of sync with the kernel.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+DEFAULT_TIMEBASE = 10000000
+
+# See export_header_t in export.h and ktrace_event_t in syscalls.h:
+EXPORT_MAGIC = 0x5058454b
+EXPORT_HEADER = struct.Struct('<6I')
+KTRACE_EVENT = struct.Struct('<QIIii')
+
+
+def load_events():
+    events = {}
+    with open(os.path.join(ROOT, 'include', 'ktrace.h')) as f:
+        for line in f:
+            m = re.match(r'#define KTRACE_EV_(\w+)\s+(\d+)', line)
+            if m:
+                events[int(m.group(2))] = m.group(1).lower()
+    return events
+
+
+def load_syscalls():
+    syscalls = {}
+    with open(os.path.join(ROOT, 'src', 'syscalls.tbl')) as f:
+        for line in f:
+            m = re.match(r'(\d+)\s+\w+\s+(\w+)\(', line)
+            if m:
+                syscalls[int(m.group(1))] = m.group(2)
+    return syscalls
+
+
+def parse_export(data):
+    """Parses a ktrace.bin, returning the same as parse()."""
+    _, _, _, record_size, timebase, _ = EXPORT_HEADER.unpack_from(data)
+    records = []
+    for off in range(EXPORT_HEADER.size, len(data) - record_size + 1,
+                     record_size):
+        time, event, hart, arg0, arg1 = KTRACE_EVENT.unpack_from(data, off)
+        records.append((time, hart, event, arg0, arg1))
+    records.sort()
+    return timebase, records
+
+
+def parse(path):
+    """Returns the timebase and the list of events as (time, hart, event,
+    arg0, arg1) tuples, sorted by time."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) >= EXPORT_HEADER.size and \
+            EXPORT_HEADER.unpack_from(data)[0] == EXPORT_MAGIC:
+        return parse_export(data)
+    timebase = DEFAULT_TIMEBASE
+    records = []
+    with open(path, errors='replace') as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 2 and fields[0] == 'ktrace-timebase':
+                timebase = int(fields[1])
+            elif len(fields) == 7 and fields[0] == 'ktrace':
+                hart, hi, lo, event, arg0, arg1 = (int(x) for x in fields[1:])
+                time = (hi & 0xffffffff) << 32 | (lo & 0xffffffff)
+                records.append((time, hart, event, arg0, arg1))
+    records.sort()
+    return timebase, records
+
+
+def signed(x):
+    x &= 0xffffffff
+    return x - (1 << 32) if x & 0x80000000 else x
+
+
+def sched_tid(hart):
+    return hart * 2
+
+
+def syscall_tid(hart):
+    return hart * 2 + 1
+
+
+def convert(timebase, records, events, syscalls):
+    out = []
+    if not records:
+        return out
+    t0 = records[0][0]
+
+    def us(time):
+        return (time - t0) * 1000000.0 / timebase
+
+    running = {}   # hart -> (pid, start time)
+    in_syscall = {}  # (hart, pid) -> (nr, start time)
+    harts = set()
+
+    def close_slice(hart, time):
+        if hart in running:
+            pid, start = running.pop(hart)
+            out.append({'name': 'pid %d' % pid, 'cat': 'sched', 'ph': 'X',
+                        'pid': 0, 'tid': sched_tid(hart), 'ts': us(start),
+                        'dur': us(time) - us(start), 'args': {'pid': pid}})
+
+    for time, hart, event, arg0, arg1 in records:
+        harts.add(hart)
+        name = events.get(event, 'event%d' % event)
+        if name == 'switch':
+            close_slice(hart, time)
+            running[hart] = (signed(arg1), time)
+        elif name == 'idle':
+            close_slice(hart, time)
+        elif name == 'syscall':
+            in_syscall[(hart, signed(arg0))] = (arg1, time)
+        elif name == 'sysret':
+            key = (hart, signed(arg0))
+            if key not in in_syscall:
+                continue
+            nr, start = in_syscall.pop(key)
+            out.append({'name': syscalls.get(nr, 'syscall%d' % nr),
+                        'cat': 'syscall', 'ph': 'X', 'pid': 0,
+                        'tid': syscall_tid(hart), 'ts': us(start),
+                        'dur': us(time) - us(start),
+                        'args': {'pid': signed(arg0), 'ret': signed(arg1)}})
+        else:
+            if name in ('trap', 'timer', 'page_alloc', 'page_free'):
+                args = {'arg0': hex(arg0 & 0xffffffff),
+                        'arg1': hex(arg1 & 0xffffffff)}
+            else:
+                args = {'arg0': signed(arg0), 'arg1': signed(arg1)}
+            out.append({'name': name, 'cat': 'kernel', 'ph': 'i', 's': 't',
+                        'pid': 0, 'tid': sched_tid(hart), 'ts': us(time),
+                        'args': args})
+    end = records[-1][0]
+    for hart in list(running):
+        close_slice(hart, end)
+    out.append({'name': 'process_name', 'ph': 'M', 'pid': 0,
+                'args': {'name': 'kernel'}})
+    for hart in sorted(harts):
+        out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0,
+                    'tid': sched_tid(hart),
+                    'args': {'name': 'hart %d' % hart}})
+        out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0,
+                    'tid': syscall_tid(hart),
+                    'args': {'name': 'hart %d syscalls' % hart}})
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('log', help='console output with the ktrace lines')
+    parser.add_argument('-o', '--output', help='write the JSON here instead '
+                        'of stdout')
+    args = parser.parse_args()
+    timebase, records = parse(args.log)
+    if not records:
+        sys.exit('ktrace-to-chrome.py: no events in %s' % args.log)
+    trace = {'traceEvents': convert(timebase, records, load_events(),
+                                    load_syscalls()),
+             'displayTimeUnit': 'ns'}
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,231 @@
+#!/usr/bin/env python3
+
+# pylint: disable=invalid-name,missing-function-docstring
+
+"""Symbolizes the samples taken by the kernel's sampling profiler and prints
+flat and per-process profiles.
+
+Usage: profile.py SAMPLES BINARY
+
+SAMPLES is the console output of the prof program (or a file with just its
+lines), or the profile.bin it exported with qemu-launcher.py --export-dir.
+BINARY is the kernel ELF the samples were taken on, e.g. out/user_sifive_u.
+The sample lines look like this:
+
+    prof <hart> <pid> <mode> <pc>
+
+Where mode is 'u', 'k' or 'i' for user, kernel or idle, see u_main_prof. The
+pcs are looked up in the symbol table of BINARY, as listed by nm. 'make
+profile' does all of this for a run of ubench.
+
+With --pccount, SAMPLES is instead the output of the qemu-pccount plugin (see
+host/qemu-pccount.c), with exact instruction counts per pc:
+
+    pccount <pc> <count>
+
+and the report is a ranking of functions by the number of instructions
+executed in them, one for the kernel and one for .user_text. 'qemu-launcher.py
+--profile' and 'make pccount' print it at the end of the run.
+"""
+
+import argparse
+import bisect
+import collections
+import shutil
+import struct
+import subprocess
+import sys
+
+NM_CANDIDATES = ['riscv64-linux-gnu-nm', 'riscv64-unknown-elf-nm', 'llvm-nm',
+                 'nm']
+
+MODES = {'u': 'user', 'k': 'kernel', 'i': 'idle'}
+
+# See export_header_t in export.h and prof_sample_t in syscalls.h:
+EXPORT_MAGIC = 0x5058454b
+EXPORT_HEADER = struct.Struct('<6I')
+PROF_SAMPLE_KERNEL = 1 << 0
+PROF_SAMPLE_IDLE = 1 << 1
+
+
+def find_nm(nm):
+    if nm:
+        return nm
+    for candidate in NM_CANDIDATES:
+        if shutil.which(candidate):
+            return candidate
+    sys.exit('profile.py: no nm found, pass one with --nm')
+
+
+def load_symbols(nm, binary):
+    """Returns a sorted list of addresses of the text symbols in binary, and
+    a parallel list of their names."""
+    out = subprocess.check_output([nm, '-n', '--defined-only', binary],
+                                  universal_newlines=True)
+    addrs, names = [], []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) != 3 or fields[1] not in 'tTwW':
+            continue
+        addrs.append(int(fields[0], 16))
+        names.append(fields[2])
+    return addrs, names
+
+
+def symbolize(addrs, names, pc):
+    i = bisect.bisect_right(addrs, pc) - 1
+    if i < 0:
+        return '0x%x' % pc
+    return names[i]
+
+
+def load_section(binary, name):
+    """Returns the (start, end) addresses of section name in the ELF binary,
+    or None if there's no such section."""
+    with open(binary, 'rb') as f:
+        data = f.read()
+    is64 = data[4] == 2
+    endian = '<' if data[5] == 1 else '>'
+    if is64:
+        shoff, = struct.unpack_from(endian + 'Q', data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', data,
+                                                        0x3a)
+        header = struct.Struct(endian + 'IIQQQQ')
+    else:
+        shoff, = struct.unpack_from(endian + 'I', data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + 'HHH', data,
+                                                        0x2e)
+        header = struct.Struct(endian + 'IIIIII')
+    sections = [header.unpack_from(data, shoff + i * shentsize)
+                for i in range(shnum)]
+    # (name, type, flags, addr, offset, size):
+    strtab = sections[shstrndx][4]
+    for sh_name, _, _, addr, _, size in sections:
+        end = data.index(b'\0', strtab + sh_name)
+        if data[strtab + sh_name:end].decode() == name:
+            return addr, addr + size
+    return None
+
+
+def parse_pccount(path):
+    """Returns the list of (pc, count) tuples in a qemu-pccount output."""
+    counts = []
+    with open(path, errors='replace') as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 3 and fields[0] == 'pccount':
+                counts.append((int(fields[1], 16), int(fields[2])))
+    return counts
+
+
+def print_pccount_report(counts, binary, nm, top):
+    addrs, names = load_symbols(nm, binary)
+    user_text = load_section(binary, '.user_text') or (0, 0)
+    total = sum(n for _, n in counts)
+    per_section = {'kernel': collections.Counter(),
+                   'user': collections.Counter()}
+    for pc, n in counts:
+        section = 'user' if user_text[0] <= pc < user_text[1] else 'kernel'
+        per_section[section][symbolize(addrs, names, pc)] += n
+    print('%d instructions executed' % total)
+    print()
+    for section in ('kernel', 'user'):
+        counter = per_section[section]
+        insns = sum(counter.values())
+        print('%s (%d instructions, %.1f%%):' % (
+            section, insns, insns * 100.0 / total if total else 0))
+        print('  %12s %6s  %s' % ('insns', '%', 'function'))
+        for sym, n in counter.most_common(top):
+            print('  %12d %5.1f%%  %s' % (n, n * 100.0 / total, sym))
+        print()
+
+
+def parse_export(data):
+    """Parses a profile.bin, returning the same as parse()."""
+    _, _, _, record_size, _, xlen = EXPORT_HEADER.unpack_from(data)
+    record = struct.Struct('<QIII' if xlen == 64 else '<IIII')
+    samples = []
+    for off in range(EXPORT_HEADER.size, len(data) - record_size + 1,
+                     record_size):
+        pc, pid, hart, flags = record.unpack_from(data, off)
+        mode = 'u'
+        if flags & PROF_SAMPLE_IDLE:
+            mode = 'i'
+        elif flags & PROF_SAMPLE_KERNEL:
+            mode = 'k'
+        if pid == 0xffffffff:
+            pid = -1
+        samples.append((hart, pid, mode, pc))
+    return samples, None
+
+
+def parse(path):
+    """Returns the list of samples as (hart, pid, mode, pc) tuples, and the
+    number of dropped samples, if the stats were in the output."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) >= EXPORT_HEADER.size and \
+            EXPORT_HEADER.unpack_from(data)[0] == EXPORT_MAGIC:
+        return parse_export(data)
+    samples = []
+    dropped = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 5 and fields[0] == 'prof':
+                samples.append((int(fields[1]), int(fields[2]), fields[3],
+                                int(fields[4], 16)))
+            elif len(fields) == 2 and fields[0] == 'dropped':
+                dropped = int(fields[1])
+    return samples, dropped
+
+
+def print_table(title, counter, total, top):
+    print(title)
+    print('  %8s %6s  %-7s %s' % ('samples', '%', 'mode', 'symbol'))
+    for (mode, sym), n in counter.most_common(top):
+        print('  %8d %5.1f%%  %-7s %s' % (n, n * 100.0 / total,
+                                          MODES.get(mode, mode), sym))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('samples', help='console output with the prof lines')
+    parser.add_argument('binary', help='the kernel ELF, e.g. out/user_sifive_u')
+    parser.add_argument('--nm', help='nm to read the symbols with')
+    parser.add_argument('--top', type=int, default=20,
+                        help='print this many symbols per profile')
+    parser.add_argument('--pccount', action='store_true',
+                        help='SAMPLES are instruction counts from qemu-pccount')
+    args = parser.parse_args()
+    if args.pccount:
+        counts = parse_pccount(args.samples)
+        if not counts:
+            sys.exit('profile.py: no counts in %s' % args.samples)
+        print_pccount_report(counts, args.binary, find_nm(args.nm), args.top)
+        return
+    samples, dropped = parse(args.samples)
+    if not samples:
+        sys.exit('profile.py: no samples in %s' % args.samples)
+    addrs, names = load_symbols(find_nm(args.nm), args.binary)
+    flat = collections.Counter()
+    per_pid = collections.defaultdict(collections.Counter)
+    for _, pid, mode, pc in samples:
+        key = (mode, symbolize(addrs, names, pc))
+        flat[key] += 1
+        per_pid[pid][key] += 1
+    summary = '%d samples' % len(samples)
+    if dropped:
+        summary += ', %d more dropped' % dropped
+    print_table('flat profile (%s):' % summary, flat, len(samples), args.top)
+    for pid in sorted(per_pid):
+        counter = per_pid[pid]
+        total = sum(counter.values())
+        title = 'idle' if pid == -1 else 'pid %d' % pid
+        print_table('%s (%d samples):' % (title, total), counter, total,
+                    args.top)
+
+
+if __name__ == '__main__':
+    main()
@@ -16,6 +16,14 @@ import sys
 DEBUG_SESSION_FILE = '.debug-session'
 GDBINIT_FILE = '.gdbinit'
 
+SCRIPTS_DIR = os.path.dirname(os.path.abspath(__file__))
+PCCOUNT_SRC = os.path.normpath(os.path.join(SCRIPTS_DIR, '..', 'host',
+                                           'qemu-pccount.c'))
+PCCOUNT_PLUGIN = 'out/qemu-pccount.so'
+# Where to look for qemu-plugin.h, if not given with --plugin-include:
+PLUGIN_INCLUDE_CANDIDATES = ['qemu-build/include', '/usr/local/include',
+                             '/usr/include/qemu', '/usr/include']
+
 
 class _Getch:
     """Gets a single character from standard input. Does not echo to the screen."""
@@ -118,6 +126,52 @@ def cleanup_gdb_files():
         os.unlink(GDBINIT_FILE)
 
 
+def qemu_version(qemu):
+    """Returns the (major, minor) version of qemu, or (0, 0) if it can't tell."""
+    try:
+        out = subprocess.check_output([qemu, '--version'],
+                                      universal_newlines=True)
+        words = out.split()
+        version = words[words.index('version') + 1].split('.')
+        return int(version[0]), int(version[1])
+    except (OSError, subprocess.CalledProcessError, ValueError, IndexError):
+        return 0, 0
+
+
+def build_pccount_plugin(include_dir):
+    """Builds the qemu-pccount TCG plugin, unless it's up to date, and returns
+    its absolute path. QEMU needs to be configured with --enable-plugins for
+    it to load, see build-qemu.sh."""
+    plugin = os.path.abspath(PCCOUNT_PLUGIN)
+    if os.path.exists(plugin) and \
+            os.path.getmtime(plugin) >= os.path.getmtime(PCCOUNT_SRC):
+        return plugin
+    if include_dir is None:
+        for candidate in PLUGIN_INCLUDE_CANDIDATES:
+            if os.path.exists(os.path.join(candidate, 'qemu-plugin.h')):
+                include_dir = candidate
+                break
+        else:
+            sys.exit('qemu-launcher: no qemu-plugin.h found, '
+                     'pass its directory with --plugin-include')
+    cmd = [os.environ.get('CC', 'cc'), '-shared', '-fPIC', '-O2',
+           '-I', include_dir]
+    # newer QEMUs include glib.h from qemu-plugin.h:
+    with contextlib.suppress(OSError, subprocess.CalledProcessError):
+        cmd.extend(subprocess.check_output(
+            ['pkg-config', '--cflags', 'glib-2.0'],
+            stderr=subprocess.DEVNULL, universal_newlines=True).split())
+    cmd.extend([PCCOUNT_SRC, '-o', plugin, '-lpthread'])
+    os.makedirs(os.path.dirname(plugin), exist_ok=True)
+    subprocess.check_call(cmd)
+    return plugin
+
+
+def pccount_file(binary):
+    return os.path.abspath(
+        'out/pccount-{}.txt'.format(os.path.basename(binary)))
+
+
 def make_qemu_command(args):
     binary = args.binary
 
@@ -140,6 +194,14 @@ def make_qemu_command(args):
 
     if os.path.isdir('qemu-build'):
         qemu = os.path.join('qemu-build/bin', qemu)
+    bootargs = args.bootargs
+    if args.export_dir:
+        # QEMU runs in the export dir, where the kernel's semihosting files
+        # land, so the paths given to it have to be absolute:
+        if os.path.sep in qemu:
+            qemu = os.path.abspath(qemu)
+        binary = os.path.abspath(binary)
+        bootargs = ' '.join(filter(None, [bootargs, 'export']))
     cmd = [qemu, '-nographic', '-machine', machine, '-bios', 'none',
            '-kernel', binary,
            ]
@@ -148,11 +210,42 @@ def make_qemu_command(args):
             '-S',  # only loads an image, but stops the CPU, giving a chance to attach gdb
             '-s',  # a shorthand to listen for gdb on localhost:1234
         ])
-    if args.bootargs:
-        cmd.extend(['-append', args.bootargs])
+    if args.export_dir:
+        # Let the kernel write its diagnostic buffers straight to host files,
+        # see export.h:
+        cmd.extend(['-semihosting-config', 'enable=on,target=native'])
+    if bootargs:
+        cmd.extend(['-append', bootargs])
+    if args.icount:
+        # Run in instruction-counting mode: the virtual clock advances by
+        # exactly 1ns per instruction and the cycle CSRs count instructions,
+        # so both the runs and the numbers measured with them are
+        # deterministic. sleep=off keeps QEMU from waiting in real time while
+        # the guest is idle.
+        cmd.extend(['-icount', 'shift=0,align=off,sleep=off'])
+    if args.profile:
+        # Count the instructions executed at every pc with the qemu-pccount
+        # plugin. QEMU before 6.0 only takes plugin args in the arg= form:
+        plugin = build_pccount_plugin(args.plugin_include)
+        outfile = 'outfile=' + pccount_file(args.binary)
+        if qemu_version(qemu) < (6, 0):
+            cmd.extend(['-plugin', 'file={},arg={}'.format(plugin, outfile)])
+        else:
+            cmd.extend(['-plugin', '{},{}'.format(plugin, outfile)])
     return cmd, machine, binary, qemu.endswith('riscv32')
 
 
+def print_pccount_report(args):
+    """Maps the counts of a --profile run to the functions of the binary, see
+    profile.py --pccount."""
+    cmd = [sys.executable, os.path.join(SCRIPTS_DIR, 'profile.py'),
+           '--pccount', pccount_file(args.binary), args.binary]
+    if args.nm:
+        cmd.extend(['--nm', args.nm])
+    sys.stdout.flush()
+    subprocess.call(cmd)
+
+
 def run(args):
     """Runs qemu in a bit more user-friendly way, capturing stdout+stderr to a
     file, allowing to terminate it with C-c and optionally exit automatically
@@ -168,7 +261,11 @@ def run(args):
     echoed to stdout as well. Very importantly, it tells the subprocess to read
     stdin from a pipe (currently not written to), which prevents qemu from
     taking ownership of stdin and allowing us to capture C-c.
+
+    Returns the exit status of qemu, or 0 if it was killed due to timeout:
+    not every machine can power qemu off, on those that's how a run ends.
     """
+    timed_out = False
     timeout = None
     if args.timeout is not None:
         timeout = mkdelta(args.timeout)
@@ -177,8 +274,10 @@ def run(args):
         is_multicore = machine == 'sifive_u'
         write_gdb_files(binary, is_32bit, is_multicore)
     filename = 'out/test-run-{}.log'.format(os.path.basename(args.binary))
+    if args.export_dir:
+        os.makedirs(args.export_dir, exist_ok=True)
     with io.open(filename, 'wb') as writer, io.open(filename, 'rb', 1) as reader:
-        p = subprocess.Popen(cmd,
+        p = subprocess.Popen(cmd, cwd=args.export_dir,
                              # stdin=subprocess.PIPE,
                              stdout=writer, stderr=writer,
                              )
@@ -189,11 +288,18 @@ def run(args):
             if timeout is not None:
                 if start + timeout < datetime.now():
                     print('\nqemu-launcher: killing qemu due to timeout')
+                    timed_out = True
                     p.terminate()
                     break
         # write the remainder:
         pipe_bytes(reader, sys.stdout)
+        # let QEMU exit on its own after terminate(), so that plugins get to
+        # write their results:
+        p.wait()
     cleanup_gdb_files()
+    if args.profile:
+        print_pccount_report(args)
+    return 0 if timed_out else p.returncode
 
 
 def main():
@@ -206,11 +312,25 @@ def main():
     parser.add_argument('--debug', help='stop to wait for gdb before executing binary',
                         action='store_true')
     parser.add_argument('--bootargs', help='pass this as bootargs to the kernel')
+    parser.add_argument('--icount', help='count instructions instead of running in real time',
+                        action='store_true')
+    parser.add_argument('--export-dir', help='enable semihosting and have the kernel export '
+                        'traces and profiles as files in this directory (see export.h)')
+    parser.add_argument('--profile', help='count the instructions executed at every pc with '
+                        'a TCG plugin, and print the most expensive functions at exit',
+                        action='store_true')
+    parser.add_argument('--plugin-include', help='directory with qemu-plugin.h, to build the '
+                        '--profile plugin with')
+    parser.add_argument('--nm', help='nm to read the symbols of the binary with, for --profile')
+    parser.add_argument('--check-status', help='exit with a non-zero status if qemu does',
+                        action='store_true')
     args = parser.parse_args()
     # c = getch()
     # print(c)
     # return
-    run(args)
+    status = run(args)
+    if args.check_status and status != 0:
+        sys.exit(1)
 
 
 if __name__ == '__main__':
@@ -62,10 +62,15 @@ bifs_file_t* bifs_open(char const *filepath, uint32_t flags) {
 int32_t bifs_read(file_t *f, uint32_t pos, void *buf, uint32_t size) {
     bifs_file_t *ff = (bifs_file_t*)f->fs_file;
     char *cbuf = (char*)buf;
-    // TODO: take pos into account
     int i = 0;
+    // skip to pos, making sure not to run past the end of data
+    for (uint32_t j = 0; j < pos; j++) {
+        if (!ff->data[j]) {
+            return 0;
+        }
+    }
     while (i < size) {
-        char ch = ff->data[i];
+        char ch = ff->data[pos + i];
         if (!ch) {
             break;
         }
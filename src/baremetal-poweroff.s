@@ -8,6 +8,19 @@
 
 poweroff:
 
+.ifdef HTIF
+        .equ HTIF_EXIT,         1       # tohost = (code << 1) | 1 ends the run
+
+        sltz    a0, a0                  # Spike exits with 0 on success, 1 on fail
+        slli    a0, a0, 1
+        ori     a0, a0, HTIF_EXIT
+        la      t0, tohost
+        sd      a0, 0(t0)               # write to HTIF, see htif.h
+
+1:      wfi
+        j       1b
+
+.else
 .ifdef QEMU_EXIT
         .equ QEMU_TEST_BASE,    QEMU_EXIT
         .equ TEST_REG_TX,       0
@@ -25,8 +38,8 @@ poweroff:
 
 .else
 
-poweroff:
 1:      wfi
         j       1b
 
 .endif
+.endif
@@ -1,6 +1,5 @@
 .include "src/machine-word.inc"
 .equ STACK_PER_HART,    64 * REGBYTES
-.equ HALT_ON_EXCEPTION, 1
 .equ CLINT0_BASE_ADDRESS, 0x2000000
 .equ BOOT_HART_ID, 0
 
@@ -31,10 +30,10 @@ _start:
 
                                         # setup stack pointer:
         la      t0, stack_top           # set it at stack_top for hart0,
-        csrr    t1, mhartid             # at stack_top+512 for hart1, etc.
-        li      t2, 512
-        mul     t1, t1, t2
-        add     t0, t0, t1
+        csrr    t1, mhartid             # at stack_top-KSTACK_SIZE for hart1,
+        li      t2, KSTACK_SIZE         # etc., the same as the trap handler
+        mul     t1, t1, t2              # does, see stackmark.h
+        sub     t0, t0, t1
         mv      sp, t0
 
         # only allow mhartid==BOOT_HART_ID to jump to the init_segments code;
@@ -74,12 +73,23 @@ init_segments:
 
         la      t0, bss_start
         la      t1, bss_end
-        bgeu    t0, t1, synchronize_harts
+        bgeu    t0, t1, paint_stacks
 clean_bss_loop:
         sw      zero, (t0)
         addi    t0, t0, 4
         bltu    t0, t1, clean_bss_loop
 
+        # Paint the kernel stacks with STACK_PAINT (see stackmark.h), so that
+        # their high-water marks can be found later. Nothing runs on them yet:
+paint_stacks:
+        la      t0, stack_bottom
+        la      t1, stack_top
+        li      t2, STACK_PAINT
+paint_stacks_loop:
+        sw      t2, (t0)
+        addi    t0, t0, 4
+        bltu    t0, t1, paint_stacks_loop
+
         # Now that the memory segments are init'ed, the boot hart will
         # synchronize all other harts: loop from 1 to NUM_HARTS, and for all of
         # them do the following: read its MSIP register, wait until they all
@@ -230,12 +240,15 @@ trap_vector:                            # 3.1.20 Machine Cause Register (mcause)
 
         # set kernel stack pointer:
         la      t0, stack_top           # set it at stack_top for hart0,
-        csrr    t1, mhartid             # at stack_top+512 for hart1, etc.
-        li      t2, 512
+        csrr    t1, mhartid             # at stack_top-KSTACK_SIZE for hart1,
+        li      t2, KSTACK_SIZE         # etc.
         mul     t1, t1, t2
         sub     t0, t0, t1
         mv      sp, t0
 
+        csrr    a0, mcause
+        call    kstat_trap              # all registers are saved, so it can
+                                        # clobber whatever it likes
         csrr    t0, mcause
         bgez    t0, exception_dispatch
 
@@ -323,13 +336,14 @@ syscall_dispatch:
         j       ret_to_user
 
 exception_epilogue:
-.if HALT_ON_EXCEPTION == 1
+        la      t0, halt_on_exception   # a sysctl, see init_trap_vector()
+        lw      t0, 0(t0)
+        beqz    t0, 2f
 1:      j       1b
-.endif
-        j       ret_to_user
+2:      j       ret_to_user
 
 interrupt_epilogue:
-        mret
+        j       ret_to_user             # restores what the dispatch clobbered
 
 
 ### Exception, Interrupt & Syscall Handlers ###################################
@@ -371,6 +385,10 @@ exception:
         call    uart_printf
         stackfree_x 5
 
+        csrr    a0, mcause              # tracepoint, see ktrace.h
+        csrr    a1, mepc
+        call    ktrace_trap
+
         lx      x1,   1, (sp)           # ra :: x1
         lx      x7,   7, (sp)           # t2 :: x7
         lx      x10, 10, (sp)           # a0 :: x10
@@ -429,6 +447,13 @@ msg_m_hello:
 msg_exception:
         .string "Exception occurred, mcause:%p mepc:%p mtval:%p (user payload at:%p, stack top:%p).\n"
 
+        # num_harts is NUM_HARTS, the number of harts synchronized at boot, for
+        # the C code, which doesn't get the assembler symbol:
+        .balign 4
+.globl num_harts
+num_harts:
+        .word NUM_HARTS
+
 .section .data
 .globl data
 bss_zero_loop_lock:
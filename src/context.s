@@ -14,6 +14,10 @@ k_interrupt_timer:
 
 .globl ret_to_user
 ret_to_user:
+        # account the time of the trap, see kstat.h. All registers get
+        # restored from trap_frame below, so it can clobber them:
+        call    kstat_trap_exit
+
         # load a pointer to trap_frame into t6:
         la      t6, trap_frame
 
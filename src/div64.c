@@ -0,0 +1,28 @@
+#include "div64.h"
+
+uint64_t udivmod64(uint64_t n, uint32_t d, uint32_t *rem) {
+#if XLEN == 64
+    if (rem) {
+        *rem = n % d;
+    }
+    return n / d;
+#else
+    uint64_t q = 0;
+    uint64_t r = 0;
+    for (int i = 63; i >= 0; i--) {
+        r = (r << 1) | ((n >> i) & 1);
+        if (r >= d) {
+            r -= d;
+            q |= (uint64_t)1 << i;
+        }
+    }
+    if (rem) {
+        *rem = r;
+    }
+    return q;
+#endif
+}
+
+uint64_t udiv64(uint64_t n, uint32_t d) {
+    return udivmod64(n, d, 0);
+}
@@ -0,0 +1,123 @@
+#include "export.h"
+#include "kernel.h"
+#include "fdt.h"
+#include "semihost.h"
+#include "ktrace.h"
+#include "profile.h"
+
+export_t export_state;
+
+int32_t export_ktrace(int32_t fd);
+int32_t export_profile(int32_t fd);
+
+// export_kinds is indexed by EXPORT_*.
+export_kind_t export_kinds[EXPORT_NUM_KINDS] _rodata = {
+    { .file_name = "ktrace.bin",  .record_size = sizeof(ktrace_event_t),
+      .dump = export_ktrace },
+    { .file_name = "profile.bin", .record_size = sizeof(prof_sample_t),
+      .dump = export_profile },
+};
+
+void export_init() {
+    export_state.lock = 0;
+    export_state.enabled = fdt_has_bootarg("export");
+    for (int i = 0; i < EXPORT_NUM_KINDS; i++) {
+        export_state.files[i] = -1;
+    }
+    if (export_state.enabled) {
+        kprintf("export: on, via semihosting\n");
+    }
+}
+
+// export_ktrace writes out the unread part of each hart's trace ring. It
+// wraps around the end of the ring at most once, so that's at most two
+// writes per hart.
+int32_t export_ktrace(int32_t fd) {
+    int32_t n = 0;
+    for (int i = 0; i < MAX_HARTS; i++) {
+        ktrace_ring_t *ring = &ktrace.harts[i];
+        acquire(&ring->lock);
+        while (ring->tail != ring->head) {
+            uint32_t start = ring->tail % KTRACE_ENTRIES;
+            uint32_t count = ring->head - ring->tail;
+            if (count > KTRACE_ENTRIES - start) {
+                count = KTRACE_ENTRIES - start;
+            }
+            if (semihost_write(fd, &ring->events[start],
+                               count * sizeof(ktrace_event_t)) != 0) {
+                release(&ring->lock);
+                return -1;
+            }
+            ring->tail += count;
+            n += count;
+        }
+        release(&ring->lock);
+    }
+    return n;
+}
+
+int32_t export_profile(int32_t fd) {
+    int32_t n = 0;
+    acquire(&profile.lock);
+    for (int i = 0; i < MAX_HARTS; i++) {
+        profile_buf_t *buf = &profile.harts[i];
+        if (buf->num_samples == 0) {
+            continue;
+        }
+        if (semihost_write(fd, buf->samples,
+                           buf->num_samples * sizeof(prof_sample_t)) != 0) {
+            release(&profile.lock);
+            return -1;
+        }
+        n += buf->num_samples;
+        buf->num_samples = 0;
+    }
+    release(&profile.lock);
+    return n;
+}
+
+// export_open creates the host file for kind and writes its header. Should be
+// called with export_state.lock held.
+int32_t export_open(uint32_t kind) {
+    export_kind_t *k = &export_kinds[kind];
+    int32_t fd = semihost_open(k->file_name, SEMIHOST_MODE_WB);
+    if (fd == -1) {
+        kprintf("export: can't create %s\n", k->file_name);
+        return -1;
+    }
+    export_header_t header;
+    header.magic = EXPORT_MAGIC;
+    header.version = EXPORT_VERSION;
+    header.kind = kind;
+    header.record_size = k->record_size;
+    header.timebase = ONE_SECOND;
+    header.xlen = XLEN;
+    if (semihost_write(fd, &header, sizeof(header)) != 0) {
+        semihost_close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int32_t export_dump(uint32_t kind, uint32_t flags) {
+    if (!export_state.enabled || kind >= EXPORT_NUM_KINDS) {
+        return -1;
+    }
+    acquire(&export_state.lock);
+    int32_t fd = export_state.files[kind];
+    if (fd == -1) {
+        fd = export_open(kind);
+        if (fd == -1) {
+            release(&export_state.lock);
+            return -1;
+        }
+        export_state.files[kind] = fd;
+    }
+    int32_t n = export_kinds[kind].dump(fd);
+    if (flags & EXPORT_CLOSE) {
+        semihost_close(fd);
+        export_state.files[kind] = -1;
+    }
+    release(&export_state.lock);
+    return n;
+}
@@ -33,6 +33,27 @@ char const* fdt_get_bootargs() {
     return bootargs;
 }
 
+int fdt_has_bootarg(char const *word) {
+    int pos = 0;
+    while (bootargs[pos]) {
+        while (bootargs[pos] == ' ') {
+            pos++;
+        }
+        int i = 0;
+        while (word[i] && bootargs[pos] == word[i]) {
+            pos++;
+            i++;
+        }
+        if (!word[i] && (bootargs[pos] == ' ' || !bootargs[pos])) {
+            return 1;
+        }
+        while (bootargs[pos] && bootargs[pos] != ' ') {
+            pos++;
+        }
+    }
+    return 0;
+}
+
 void fdt_parse(uint32_t *tree, char const *strings) {
     if (bswap(*tree) != FDT_BEGIN_NODE) {
         return;
@@ -1,12 +1,15 @@
 #include "fs.h"
 #include "bakedinfs.h"
+#include "procfs.h"
 
 file_table_t ftable;
 
 void fs_init() {
     ftable.lock = 0;
     for (int i = 0; i < MAX_FILES; i++) {
-        ftable.files[i].fs_file = FFLAGS_FREE;
+        ftable.files[i].flags = FFLAGS_FREE;
+        ftable.files[i].fs_file = 0;
+        ftable.files[i].close = 0;
     }
     bifs_init();
 }
@@ -14,7 +17,7 @@ void fs_init() {
 file_t* fs_alloc_file() {
     acquire(&ftable.lock);
     for (int i = 0; i < MAX_FILES; i++) {
-        if (ftable.files[i].fs_file == 0) {
+        if (ftable.files[i].flags == FFLAGS_FREE) {
             ftable.files[i].flags = FFLAGS_ALLOCED;
             release(&ftable.lock);
             return &ftable.files[i];
@@ -26,10 +29,22 @@ file_t* fs_alloc_file() {
 }
 
 void fs_free_file(file_t *f) {
+    if (f->close) {
+        f->close(f);
+    }
+    acquire(&ftable.lock);
+    f->close = 0;
+    f->fs_file = 0;
     f->flags = FFLAGS_FREE;
+    release(&ftable.lock);
 }
 
 int32_t fs_open(file_t *f, char const *filepath, uint32_t flags) {
+    f->position = 0;
+    f->fs_id = 0;
+    if (procfs_owns_path(filepath)) {
+        return procfs_open(f, filepath, flags);
+    }
     f->fs_file = (void*)bifs_open(filepath, flags);
     if (!f->fs_file) {
         // TODO: errno = ENOENT
@@ -41,7 +56,11 @@ int32_t fs_open(file_t *f, char const *filepath, uint32_t flags) {
 }
 
 int32_t fs_read(file_t *f, uint32_t pos, void *buf, uint32_t size) {
-    return f->read(f, pos, buf, size);
+    int32_t nread = f->read(f, pos, buf, size);
+    if (nread > 0) {
+        f->position = pos + nread;
+    }
+    return nread;
 }
 
 int32_t fs_write(file_t *f, uint32_t pos, void *buf, uint32_t nbytes) {
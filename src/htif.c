@@ -0,0 +1,28 @@
+#include "htif.h"
+
+// Spike polls tohost every few thousand instructions, so the two are kept on
+// cache lines of their own to not be in anybody's way.
+volatile uint64_t tohost __attribute__((aligned(64)));
+volatile uint64_t fromhost __attribute__((aligned(64)));
+
+// htif_command sends cmd and waits for the reply to it.
+uint64_t htif_command(uint64_t cmd) {
+    tohost = cmd;
+    uint64_t reply;
+    do {
+        reply = fromhost;
+    } while (reply == 0);
+    fromhost = 0;
+    return reply;
+}
+
+void htif_putchar(char ch) {
+    htif_command(HTIF_COMMAND(HTIF_DEV_CONSOLE, HTIF_CMD_PUTCHAR,
+                              (unsigned char)ch));
+}
+
+char htif_getchar() {
+    uint64_t reply = htif_command(HTIF_COMMAND(HTIF_DEV_CONSOLE,
+                                               HTIF_CMD_GETCHAR, 0));
+    return reply & 0xff;
+}
@@ -0,0 +1,137 @@
+#include "ioring.h"
+#include "proc.h"
+#include "syscalls.h"
+
+// ioring_exec executes a single non-sleeping submission by calling the handler
+// of the equivalent syscall, so the semantics are exactly the same.
+int32_t ioring_exec(ioring_sqe_t *sqe) {
+    switch (sqe->op) {
+        case IORING_OP_NOP:
+            return 0;
+        case IORING_OP_READ:
+            return sys_read(sqe->fd, (char*)sqe->addr, sqe->len);
+        case IORING_OP_WRITE:
+            return sys_write(sqe->fd, (char const*)sqe->addr, sqe->len);
+        case IORING_OP_OPEN:
+            return sys_open((char const*)sqe->addr, sqe->len);
+        case IORING_OP_CLOSE:
+            return sys_close(sqe->fd);
+    }
+    // TODO: errno = EINVAL
+    return -1;
+}
+
+// ioring_may_block tells whether executing sqe could block the kernel, which
+// is not allowed on the tick.
+int ioring_may_block(ioring_sqe_t *sqe) {
+    if (sqe->op == IORING_OP_SLEEP) {
+        return 1;
+    }
+    return sqe->op == IORING_OP_READ && sqe->fd == FD_STDIN;
+}
+
+// ioring_drain executes the pending submissions in order. It stops when the
+// submission ring is empty, the completion ring is full, or when it meets a
+// submission that it can't execute in this context. On the tick that's any
+// one that may block, they're left for ioring_enter(). From ioring_enter(), a
+// sleep is consumed and completed, and then the drain stops, leaving the
+// sleeping to the caller: *sleep_ms gets the duration.
+//
+// Returns the number of consumed submissions.
+uint32_t ioring_drain(ioring_t *ring, int on_tick, uint32_t *sleep_ms) {
+    uint32_t consumed = 0;
+    uint32_t head = ring->sq_head;
+    uint32_t tail = ring->sq_tail;
+    if (tail - head > IORING_ENTRIES) {
+        // the process has corrupted its ring
+        return 0;
+    }
+    __sync_synchronize(); // don't read the submissions before the tail
+    while (head != tail) {
+        if (ring->cq_tail - ring->cq_head >= IORING_ENTRIES) {
+            break;
+        }
+        ioring_sqe_t *sqe = &ring->sqes[head & IORING_MASK];
+        if (on_tick && ioring_may_block(sqe)) {
+            break;
+        }
+        int32_t res = 0;
+        if (sqe->op == IORING_OP_SLEEP) {
+            *sleep_ms = sqe->len;
+        } else {
+            res = ioring_exec(sqe);
+        }
+        ioring_cqe_t *cqe = &ring->cqes[ring->cq_tail & IORING_MASK];
+        cqe->user_data = sqe->user_data;
+        cqe->res = res;
+        __sync_synchronize(); // publish the completion before the tail
+        ring->cq_tail++;
+        head++;
+        ring->sq_head = head;
+        consumed++;
+        if (sqe->op == IORING_OP_SLEEP) {
+            break;
+        }
+    }
+    return consumed;
+}
+
+int32_t proc_ioring_setup(ioring_t *ring) {
+    process_t *proc = myproc();
+    acquire(PROC_LOCK(proc));
+    if (ring) {
+        // the ring is accessed on the tick, long after the syscall returns,
+        // so make sure it's entirely within the process's memory:
+        regsize_t start = (regsize_t)proc->stack_page;
+        regsize_t addr = (regsize_t)ring;
+        if (addr < start || addr + sizeof(ioring_t) > start + PAGE_SIZE
+            || addr % sizeof(regsize_t) != 0) {
+            release(PROC_LOCK(proc));
+            // TODO: errno = EFAULT
+            return -1;
+        }
+        ring->sq_head = 0;
+        ring->sq_tail = 0;
+        ring->cq_head = 0;
+        ring->cq_tail = 0;
+    }
+    proc->ioring = ring;
+    release(PROC_LOCK(proc));
+    return 0;
+}
+
+int32_t proc_ioring_enter() {
+    process_t *proc = myproc();
+    acquire(PROC_LOCK(proc));
+    ioring_t *ring = proc->ioring;
+    release(PROC_LOCK(proc));
+    if (!ring) {
+        // TODO: errno = EINVAL
+        return -1;
+    }
+    uint32_t sleep_ms = 0;
+    uint32_t consumed = ioring_drain(ring, 0, &sleep_ms);
+    if (sleep_ms) {
+        // proc_sleep switches to another process, so set the return value in
+        // the context that gets saved:
+        trap_frame.regs[REG_A0] = consumed;
+        proc_sleep(sleep_ms);
+    }
+    return consumed;
+}
+
+void proc_ioring_tick() {
+    acquire(&proc_table.lock);
+    if (proc_table.is_idle || proc_table.num_procs == 0) {
+        release(&proc_table.lock);
+        return;
+    }
+    process_t *proc = proc_table.procs[proc_table.curr_proc];
+    release(&proc_table.lock);
+    acquire(PROC_LOCK(proc));
+    ioring_t *ring = proc->ioring;
+    release(PROC_LOCK(proc));
+    if (ring) {
+        ioring_drain(ring, 1, 0);
+    }
+}
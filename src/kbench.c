@@ -0,0 +1,127 @@
+#include "kbench.h"
+#include "kernel.h"
+#include "proc.h"
+#include "pagealloc.h"
+#include "bakedinfs.h"
+#include "fs.h"
+#include "div64.h"
+#include "syscalls.h"
+
+trap_frame_t kbench_frames[2];
+spinlock kbench_lock;
+
+void kbench_empty(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        asm volatile ("" ::: "memory"); // keep the loop
+    }
+}
+
+void kbench_page(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        release_page(allocate_page());
+    }
+}
+
+void kbench_spinlock(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        acquire(&kbench_lock);
+        release(&kbench_lock);
+    }
+}
+
+void kbench_copy_context(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        copy_context(&kbench_frames[i & 1], &kbench_frames[~i & 1]);
+    }
+}
+
+// kbench_setup_procs grows the process table as far as it goes, MAX_PROCS
+// slots unless it runs out of pages, and fills it so that find_ready_proc()
+// has to scan it all: every process sleeps for good, except for the one in
+// slot 0, which a scan starting from slot 0 reaches last.
+int kbench_setup_procs() {
+    acquire(&proc_table.lock);
+    while (grow_proc_table())
+        ;
+    release(&proc_table.lock);
+    for (int i = 0; i < proc_table.capacity; i++) {
+        proc_table.states[i] = PROC_STATE_SLEEPING;
+        proc_table.wakeup_times[i] = -1;
+    }
+    proc_table.states[0] = PROC_STATE_READY;
+    return proc_table.capacity;
+}
+
+void kbench_find_ready_proc(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        find_ready_proc(0);
+    }
+}
+
+void kbench_bifs_open(uint32_t iters) {
+    for (uint32_t i = 0; i < iters; i++) {
+        bifs_open("/home/read.me", 0);
+    }
+}
+
+// kbench_setup_fs initializes the filesystems, since fs_init() only runs
+// after init_test_processes() in kinit().
+int kbench_setup_fs() {
+    fs_init();
+    return 0;
+}
+
+kbench_t kbenches[] _rodata = {
+    {"empty",           0,                  kbench_empty,           100},
+    {"page",            0,                  kbench_page,            100},
+    {"spinlock",        0,                  kbench_spinlock,        100},
+    {"copy_context",    0,                  kbench_copy_context,    100},
+    {"find_ready_proc", kbench_setup_procs, kbench_find_ready_proc, 100},
+    {"bifs_open",       kbench_setup_fs,    kbench_bifs_open,       100},
+};
+
+// kbench_sort sorts the n samples in place. There's only a handful of them,
+// an insertion sort will do.
+void kbench_sort(uint32_t *samples, int n) {
+    for (int i = 1; i < n; i++) {
+        uint32_t s = samples[i];
+        int j = i - 1;
+        while (j >= 0 && samples[j] > s) {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = s;
+    }
+}
+
+void kbench_run(kbench_t *b) {
+    uint32_t samples[KBENCH_RUNS];
+    int size = 0;
+    if (b->setup) {
+        size = b->setup();
+    }
+    for (int i = 0; i < KBENCH_WARMUP_RUNS; i++) {
+        b->run(b->iters);
+    }
+    for (int i = 0; i < KBENCH_RUNS; i++) {
+        uint64_t start = get_mcycle();
+        b->run(b->iters);
+        samples[i] = (uint32_t)udiv64(get_mcycle() - start, b->iters);
+    }
+    kbench_sort(samples, KBENCH_RUNS);
+    if (size) {
+        kprintf("kbench %s/%d %d %d %d\n", b->name, size, samples[0],
+                samples[KBENCH_RUNS / 2], samples[KBENCH_RUNS - 1]);
+    } else {
+        kprintf("kbench %s %d %d %d\n", b->name, samples[0],
+                samples[KBENCH_RUNS / 2], samples[KBENCH_RUNS - 1]);
+    }
+}
+
+void kbench_run_all() {
+    kbench_lock = 0;
+    for (int i = 0; i < ARRAY_LENGTH(kbenches); i++) {
+        kbench_run(&kbenches[i]);
+    }
+    poweroff();
+}
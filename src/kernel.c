@@ -5,8 +5,17 @@
 #include "fdt.h"
 #include "pagealloc.h"
 #include "uart.h"
+#include "sysctl.h"
+#include "vdso.h"
+#include "strace.h"
+#include "profile.h"
+#include "perf.h"
+#include "ktrace.h"
+#include "export.h"
+#include "kstat.h"
 
 spinlock init_lock = 0;
+uint32_t halt_on_exception;
 
 void kinit(uintptr_t fdt_header_addr) {
     acquire(&init_lock);
@@ -17,10 +26,18 @@ void kinit(uintptr_t fdt_header_addr) {
         // TODO: support multi-core
         park_hart();
     }
+    kstat_cpu_init();
     uart_init();
     kprintf("kinit: cpu %d\n", cpu_id);
     fdt_init(fdt_header_addr);
     kprintf("bootargs: %s\n", fdt_get_bootargs());
+    sysctl_init();
+    export_init();
+    vdso_init();
+    strace_init();
+    profile_init();
+    perf_init();
+    ktrace_init();
     init_trap_vector();
     void* paged_mem_end = init_pmp();
     char const* str = "foo"; // this is a random string to test out %s in kprintf()
@@ -30,7 +47,9 @@ void kinit(uintptr_t fdt_header_addr) {
     init_process_table();
     init_global_trap_frame();
     fs_init();
-    set_timer_after(KERNEL_SCHEDULER_TICK_TIME);
+    sysctl_apply_bootargs(fdt_get_bootargs());
+    set_timer_after(sched_tick_time);
+    kstat_cpu_switch(KSTAT_CPU_IDLE);
     enable_interrupts();
     release(&init_lock);
     // after kinit() is done, halt this hart until the timer gets called, all
@@ -61,6 +80,9 @@ void kinit(uintptr_t fdt_header_addr) {
 void init_trap_vector() {
     extern void* trap_vector;  // defined in boot.s
     set_mtvec(&trap_vector);
+    halt_on_exception = KERNEL_HALT_ON_EXCEPTION;
+    sysctl_register("kernel.halt_on_exception", SYSCTL_TYPE_BOOL,
+                    &halt_on_exception, 0, 1);
 }
 
 // kernel_timer_tick will be called from timer to give kernel time to do its
@@ -68,12 +90,31 @@ void init_trap_vector() {
 // run.
 void kernel_timer_tick() {
     disable_interrupts();
+    KSTAT_INC(timer_irqs);
+    // mstatus.MPP still holds the mode that the interrupt came from:
+    uint32_t prof_flags = 0;
+    if ((get_mstatus() & ~MODE_MASK) != MODE_U) {
+        prof_flags |= PROF_SAMPLE_KERNEL;
+    }
+    uint32_t pid = -1;
     acquire(&proc_table.lock);
     if (!proc_table.is_idle) {
-        copy_context(&proc_table.procs[proc_table.curr_proc].context, &trap_frame);
+        pid = proc_table.procs[proc_table.curr_proc]->pid;
+        copy_context(&proc_table.procs[proc_table.curr_proc]->context, &trap_frame);
+    } else {
+        prof_flags |= PROF_SAMPLE_IDLE;
     }
     release(&proc_table.lock);
-    set_timer_after(KERNEL_SCHEDULER_TICK_TIME);
+    KTRACE(KTRACE_EV_TIMER, pid, trap_frame.pc);
+    if (profile_tick(trap_frame.pc, pid, prof_flags)) {
+        // the interrupt was only due for a profiler sample, let whatever was
+        // interrupted carry on:
+        enable_interrupts();
+        return;
+    }
+    set_timer_after(profile_timer_interval());
+    proc_ioring_tick();
+    proc_calc_load();
     schedule_user_process();
     enable_interrupts();
 }
@@ -0,0 +1,94 @@
+#include "kstat.h"
+#include "kernel.h"
+#include "proc.h"
+
+kstat_t kstat;
+
+void kstat_cpu_init() {
+    kstat_hart_t *hart = &kstat.harts[get_mhartid()];
+    hart->cpu_state = KSTAT_CPU_KERNEL;
+    hart->cpu_since = time_get_now();
+    hart->cpu_active = 1;
+}
+
+void kstat_cpu_switch(uint32_t state) {
+    kstat_hart_t *hart = &kstat.harts[get_mhartid()];
+    uint64_t now = time_get_now();
+    hart->cpu_time[hart->cpu_state] += now - hart->cpu_since;
+    hart->cpu_since = now;
+    hart->cpu_state = state;
+}
+
+void kstat_trap(regsize_t mcause) {
+    KSTAT_INC(traps);
+    // the top bit of mcause is set for interrupts:
+    int irq = (mcause >> (XLEN - 1)) & 1;
+    kstat_cpu_switch(irq ? KSTAT_CPU_IRQ : KSTAT_CPU_KERNEL);
+}
+
+// kstat_trap_exit reads proc_table.is_idle without the lock. Only the boot
+// hart runs the scheduler, the others are parked in kinit(), so only the boot
+// hart ever gets to ret_to_user. is_idle is written by the scheduler and by
+// proc_exit(), which run on that same hart, so it can't change under us.
+void kstat_trap_exit() {
+    // a trap that came while idle, e.g. a profiler tick, goes back to idle:
+    kstat_cpu_switch(proc_table.is_idle ? KSTAT_CPU_IDLE : KSTAT_CPU_USER);
+}
+
+void kstat_sum(kstat_counts_t *sum) {
+    sum->traps = 0;
+    sum->timer_irqs = 0;
+    sum->syscalls = 0;
+    sum->ctx_switches = 0;
+    sum->idle = 0;
+    sum->page_allocs = 0;
+    sum->page_frees = 0;
+    sum->fork_fails = 0;
+    for (int i = 0; i < MAX_HARTS; i++) {
+        kstat_counts_t *c = &kstat.harts[i].counts;
+        sum->traps += c->traps;
+        sum->timer_irqs += c->timer_irqs;
+        sum->syscalls += c->syscalls;
+        sum->ctx_switches += c->ctx_switches;
+        sum->idle += c->idle;
+        sum->page_allocs += c->page_allocs;
+        sum->page_frees += c->page_frees;
+        sum->fork_fails += c->fork_fails;
+    }
+}
+
+int32_t kstat_cpu_read(uint32_t hart, uint64_t *times) {
+    if (hart >= MAX_HARTS || !kstat.harts[hart].cpu_active) {
+        return -1;
+    }
+    kstat_hart_t *h = &kstat.harts[hart];
+    for (int i = 0; i < KSTAT_CPU_STATES; i++) {
+        times[i] = h->cpu_time[i];
+    }
+    // the state the hart is in now hasn't been charged yet. It's read without
+    // a lock, so it may be off by a switch if the hart is busy:
+    uint64_t since = h->cpu_since;
+    uint64_t now = time_get_now();
+    if (now > since) {
+        times[h->cpu_state] += now - since;
+    }
+    return 0;
+}
+
+uint32_t kstat_cpu_sum(uint64_t *times) {
+    uint32_t harts = 0;
+    for (int i = 0; i < KSTAT_CPU_STATES; i++) {
+        times[i] = 0;
+    }
+    for (uint32_t hart = 0; hart < MAX_HARTS; hart++) {
+        uint64_t t[KSTAT_CPU_STATES];
+        if (kstat_cpu_read(hart, t) != 0) {
+            continue;
+        }
+        for (int i = 0; i < KSTAT_CPU_STATES; i++) {
+            times[i] += t[i];
+        }
+        harts++;
+    }
+    return harts;
+}
@@ -0,0 +1,78 @@
+#include "ktrace.h"
+#include "kernel.h"
+#include "sysctl.h"
+
+ktrace_t ktrace;
+
+void ktrace_init() {
+    ktrace.enable = 0;
+    ktrace.mask = -1;
+    ktrace.ignore_pid = -1;
+    for (int i = 0; i < MAX_HARTS; i++) {
+        ktrace.harts[i].lock = 0;
+        ktrace.harts[i].head = 0;
+        ktrace.harts[i].tail = 0;
+        ktrace.harts[i].dropped = 0;
+    }
+    sysctl_register("ktrace.enable", SYSCTL_TYPE_BOOL, &ktrace.enable, 0, 1);
+    sysctl_register("ktrace.mask", SYSCTL_TYPE_UINT, &ktrace.mask,
+                    0, 0xffffffff);
+    sysctl_register("ktrace.ignore_pid", SYSCTL_TYPE_UINT, &ktrace.ignore_pid,
+                    0, 0xffffffff);
+}
+
+void ktrace_record(uint32_t event, uint32_t arg0, uint32_t arg1) {
+    if (!(ktrace.mask & (1 << event))) {
+        return;
+    }
+    uint32_t hart = get_mhartid();
+    ktrace_ring_t *ring = &ktrace.harts[hart];
+    uint64_t now = time_get_now();
+    acquire(&ring->lock);
+    if (ring->head - ring->tail == KTRACE_ENTRIES) {
+        ring->tail++; // overwrite the oldest event
+        ring->dropped++;
+    }
+    ktrace_event_t *e = &ring->events[ring->head % KTRACE_ENTRIES];
+    ring->head++;
+    e->time = now;
+    e->event = event;
+    e->hart = hart;
+    e->args[0] = arg0;
+    e->args[1] = arg1;
+    release(&ring->lock);
+}
+
+void ktrace_trap(regsize_t cause, regsize_t pc) {
+    KTRACE(KTRACE_EV_TRAP, cause, pc);
+}
+
+uint32_t ktrace_read(ktrace_event_t *buf, uint32_t size) {
+    uint32_t n = 0;
+    for (int i = 0; i < MAX_HARTS && n < size; i++) {
+        ktrace_ring_t *ring = &ktrace.harts[i];
+        acquire(&ring->lock);
+        while (ring->tail != ring->head && n < size) {
+            ktrace_event_t *e = &ring->events[ring->tail % KTRACE_ENTRIES];
+            buf[n].time = e->time;
+            buf[n].event = e->event;
+            buf[n].hart = e->hart;
+            buf[n].args[0] = e->args[0];
+            buf[n].args[1] = e->args[1];
+            ring->tail++;
+            n++;
+        }
+        release(&ring->lock);
+    }
+    return n;
+}
+
+uint32_t ktrace_dropped() {
+    uint32_t dropped = 0;
+    for (int i = 0; i < MAX_HARTS; i++) {
+        acquire(&ktrace.harts[i].lock);
+        dropped += ktrace.harts[i].dropped;
+        release(&ktrace.harts[i].lock);
+    }
+    return dropped;
+}
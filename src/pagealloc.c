@@ -1,7 +1,12 @@
 #include "pagealloc.h"
 #include "kernel.h"
+#include "sysctl.h"
+#include "vdso.h"
+#include "ktrace.h"
+#include "kstat.h"
 
 paged_mem_t paged_memory;
+uint32_t page_alloc_policy;
 
 void init_paged_memory(void* paged_mem_end) {
     regsize_t unclaimed_start = (regsize_t)&stack_top;
@@ -23,16 +28,32 @@ void init_paged_memory(void* paged_mem_end) {
         i++;
     }
     paged_memory.num_pages = i;
+    paged_memory.next_page = 0;
+    vdso_set_ram(i, i);
+    page_alloc_policy = PAGE_ALLOC_FIRST_FIT;
+    sysctl_register("mm.alloc_policy", SYSCTL_TYPE_UINT, &page_alloc_policy,
+                    PAGE_ALLOC_FIRST_FIT, PAGE_ALLOC_NEXT_FIT);
     kprintf("paged memory: start=%p, end=%p, npages=%d\n",
             paged_mem_start, paged_mem_end, paged_memory.num_pages);
 }
 
 void* allocate_page() {
     acquire(&paged_memory.lock);
-    for (int i = 0; i < paged_memory.num_pages; i++) {
+    uint32_t i = 0;
+    if (page_alloc_policy == PAGE_ALLOC_NEXT_FIT) {
+        i = paged_memory.next_page;
+    }
+    for (uint32_t n = 0; n < paged_memory.num_pages; n++, i++) {
+        if (i >= paged_memory.num_pages) {
+            i = 0;
+        }
         page_t* page = &paged_memory.pages[i];
         if (page->flags == PAGE_FREE) {
             page->flags = PAGE_ALLOCATED;
+            paged_memory.next_page = i + 1;
+            vdso_add_freeram(-1);
+            KSTAT_INC(page_allocs);
+            KTRACE(KTRACE_EV_PAGE_ALLOC, page->ptr, 1);
             release(&paged_memory.lock);
             return page->ptr;
         }
@@ -41,6 +62,33 @@ void* allocate_page() {
     return 0;
 }
 
+void* allocate_pages(uint32_t n) {
+    acquire(&paged_memory.lock);
+    // pages[] is filled in address order, so a run of free neighbours in it
+    // is a run of contiguous memory:
+    uint32_t run = 0;
+    for (int i = 0; i < paged_memory.num_pages; i++) {
+        if (paged_memory.pages[i].flags != PAGE_FREE) {
+            run = 0;
+            continue;
+        }
+        run++;
+        if (run == n) {
+            int first = i - n + 1;
+            for (int j = first; j <= i; j++) {
+                paged_memory.pages[j].flags = PAGE_ALLOCATED;
+            }
+            vdso_add_freeram(-(int32_t)n);
+            KSTAT_ADD(page_allocs, n);
+            KTRACE(KTRACE_EV_PAGE_ALLOC, paged_memory.pages[first].ptr, n);
+            release(&paged_memory.lock);
+            return paged_memory.pages[first].ptr;
+        }
+    }
+    release(&paged_memory.lock);
+    return 0;
+}
+
 void release_page(void *ptr) {
     acquire(&paged_memory.lock);
     for (int i = 0; i < paged_memory.num_pages; i++) {
@@ -52,6 +100,9 @@ void release_page(void *ptr) {
                 return;
             }
             page->flags = PAGE_FREE;
+            vdso_add_freeram(1);
+            KSTAT_INC(page_frees);
+            KTRACE(KTRACE_EV_PAGE_FREE, ptr, 1);
             release(&paged_memory.lock);
             return;
         }
@@ -0,0 +1,98 @@
+#include "perf.h"
+#include "kernel.h"
+#include "sysctl.h"
+
+perf_t perf;
+
+void perf_init() {
+    for (int i = 0; i < PERF_NUM_HPM; i++) {
+        perf.events[i] = 0;
+    }
+    for (int i = 0; i < MAX_HARTS; i++) {
+        for (int j = 0; j < PERF_NUM_HPM; j++) {
+            perf.harts[i].applied[j] = 0;
+        }
+    }
+    sysctl_register("perf.event3", SYSCTL_TYPE_UINT, &perf.events[0],
+                    0, 0xffffffff);
+    sysctl_register("perf.event4", SYSCTL_TYPE_UINT, &perf.events[1],
+                    0, 0xffffffff);
+}
+
+void perf_read_counters(perf_counts_t *counts) {
+    counts->cycles = get_mcycle();
+    counts->instret = get_minstret();
+    counts->hpm[0] = get_mhpmcounter3();
+    counts->hpm[1] = get_mhpmcounter4();
+}
+
+void perf_add(perf_counts_t *dst, perf_counts_t *src) {
+    dst->cycles += src->cycles;
+    dst->instret += src->instret;
+    for (int i = 0; i < PERF_NUM_HPM; i++) {
+        dst->hpm[i] += src->hpm[i];
+    }
+}
+
+void perf_zero(perf_counts_t *counts) {
+    counts->cycles = 0;
+    counts->instret = 0;
+    for (int i = 0; i < PERF_NUM_HPM; i++) {
+        counts->hpm[i] = 0;
+    }
+}
+
+void perf_copy(perf_counts_t *dst, perf_counts_t *src) {
+    perf_zero(dst);
+    perf_add(dst, src);
+}
+
+// perf_charge adds the counts since the hart's last switch to proc, if there
+// is one, and restarts counting from now.
+void perf_charge(perf_hart_t *hart, process_t *proc) {
+    perf_counts_t now;
+    perf_read_counters(&now);
+    if (proc) {
+        proc->perf.cycles += now.cycles - hart->start.cycles;
+        proc->perf.instret += now.instret - hart->start.instret;
+        for (int i = 0; i < PERF_NUM_HPM; i++) {
+            proc->perf.hpm[i] += now.hpm[i] - hart->start.hpm[i];
+        }
+    }
+    perf_copy(&hart->start, &now);
+}
+
+void perf_switch(process_t *last) {
+    perf_hart_t *hart = &perf.harts[get_mhartid()];
+    // the counts taken so far belong to the old events, so charge them before
+    // switching to new ones:
+    perf_charge(hart, last);
+    if (hart->applied[0] != perf.events[0]) {
+        hart->applied[0] = perf.events[0];
+        set_mhpmevent3(hart->applied[0]);
+        hart->start.hpm[0] = get_mhpmcounter3();
+    }
+    if (hart->applied[1] != perf.events[1]) {
+        hart->applied[1] = perf.events[1];
+        set_mhpmevent4(hart->applied[1]);
+        hart->start.hpm[1] = get_mhpmcounter4();
+    }
+}
+
+void perf_reset(process_t *proc) {
+    perf_zero(&proc->perf);
+    perf_zero(&proc->perf_children);
+}
+
+void perf_exit(process_t *proc, process_t *parent) {
+    perf_charge(&perf.harts[get_mhartid()], proc);
+    if (parent) {
+        perf_add(&parent->perf_children, &proc->perf);
+        perf_add(&parent->perf_children, &proc->perf_children);
+    }
+}
+
+void perf_stat(process_t *proc, perf_stat_t *stat) {
+    perf_copy(&stat->self, &proc->perf);
+    perf_copy(&stat->children, &proc->perf_children);
+}
@@ -28,30 +28,40 @@ void* init_pmp() {
     regsize_t ram_size = (regsize_t)&RAM_SIZE;
     void* paged_mem_end = (void*)(ram_start + ram_size);
 
-    // define 4 memory address ranges for Physical Memory Protection
+    // define 5 memory address ranges for Physical Memory Protection
     // 0 :: [0 .. user_payload]
     // 1 :: [user_payload .. .rodata]
-    // 2 :: [.rodata .. stack_bottom]
-    // 3 :: [stack_bottom .. paged_mem_end]
+    // 2 :: [.rodata .. vdso_start]
+    // 3 :: [vdso_start .. stack_bottom]
+    // 4 :: [stack_bottom .. paged_mem_end]
     set_pmpaddr0(&user_payload);
     set_pmpaddr1(&rodata);
-    set_pmpaddr2(&stack_bottom);
-    set_pmpaddr3(paged_mem_end);
+    set_pmpaddr2(&vdso_start);
+    set_pmpaddr3(&stack_bottom);
+    set_pmpaddr4(paged_mem_end);
 
-    // set 4 PMP entries to TOR (Top Of the address Range) addressing mode so that the associated
+    // set 5 PMP entries to TOR (Top Of the address Range) addressing mode so that the associated
     // address register forms the top of the address range per entry,
     // the type of PMP entry is encoded in 2 bits: OFF = 0, TOR = 1, NA4 = 2, NAPOT = 3
     // and stored in 3:4 bits of every PMP entry
     unsigned long mode = PMP_TOR * (PMP_0 | PMP_1 | PMP_2 | PMP_3);
 
-    // set access flags for 4 PMP entries:
+    // set access flags for 5 PMP entries:
     // 0 :: [0 .. user_payload]                      000  M-mode kernel code, no access in U-mode
     // 1 :: [user_payload .. .rodata]                X0R  user code, executable, non-modifiable in U-mode
-    // 2 :: [.rodata .. stack_bottom]                000  no access in U-mode
-    // 3 :: [stack_bottom .. paged_mem_end]          0WR  user stack, modifiable, but no executable in U-mode
+    // 2 :: [.rodata .. vdso_start]                  000  no access in U-mode
+    // 3 :: [vdso_start .. stack_bottom]             00R  vdso data, read-only in U-mode
+    // 4 :: [stack_bottom .. paged_mem_end]          0WR  user stack, modifiable, but no executable in U-mode
     // access (R)ead, (W)rite and e(X)ecute are 1 bit flags and stored in 0:2 bits of every PMP entry
     unsigned long access_flags =   ((PMP_X | PMP_R) * PMP_1)
-                                 | ((PMP_W | PMP_R) * PMP_3);
+                                 | (PMP_R * PMP_3);
+    unsigned long entry4 = (PMP_TOR | PMP_W | PMP_R) * PMP_4;
+#if XLEN == 64
+    // rv64 packs 8 entries into pmpcfg0
+    set_pmpcfg0(mode | access_flags | entry4);
+#else
     set_pmpcfg0(mode | access_flags);
+    set_pmpcfg1(entry4);
+#endif
     return paged_mem_end;
 }
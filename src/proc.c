@@ -3,17 +3,41 @@
 #include "programs.h"
 #include "kernel.h"
 #include "string.h"
+#include "sysctl.h"
+#include "vdso.h"
+#include "strace.h"
+#include "profile.h"
+#include "perf.h"
+#include "ktrace.h"
+#include "div64.h"
+#include "stackmark.h"
+#include "kstat.h"
 
 proc_table_t proc_table;
 trap_frame_t trap_frame;
+uint32_t sched_tick_time;
 
 void init_process_table() {
+    sched_tick_time = KERNEL_SCHEDULER_TICK_TIME;
+    sysctl_register("sched.tick", SYSCTL_TYPE_UINT, &sched_tick_time,
+                    KERNEL_SCHEDULER_TICK_MIN, KERNEL_SCHEDULER_TICK_MAX);
     proc_table.curr_proc = 0;
     proc_table.pid_counter = 0;
     proc_table.is_idle = 1;
+    proc_table.capacity = 0;
     for (int i = 0; i < MAX_PROCS; i++) {
-        proc_table.procs[i].state = PROC_STATE_AVAILABLE;
+        proc_table.procs[i] = 0;
+        proc_table.states[i] = PROC_STATE_AVAILABLE;
+        proc_table.priorities[i] = 0;
     }
+    for (int i = 0; i < PID_HASH_SIZE; i++) {
+        proc_table.pid_hash[i] = -1;
+    }
+    for (int i = 0; i < ARRAY_LENGTH(proc_table.loadavg); i++) {
+        proc_table.loadavg[i] = 0;
+    }
+    proc_table.next_load_time = time_get_now() + LOAD_FREQ;
+    schedlat_reset(&proc_table.schedlat);
     init_test_processes();
 }
 
@@ -45,18 +69,24 @@ void init_global_trap_frame() {
 void schedule_user_process() {
     uint64_t now = time_get_now();
     acquire(&proc_table.lock);
+    if (proc_table.num_procs == 0) {
+        release(&proc_table.lock);
+        return;
+    }
     int curr_proc = proc_table.curr_proc;
-    process_t *last_proc = &proc_table.procs[curr_proc];
-    if (last_proc->state == PROC_STATE_AVAILABLE || proc_table.is_idle) {
+    process_t *last_proc = proc_table.procs[curr_proc];
+    if (PROC_STATE(last_proc) == PROC_STATE_AVAILABLE || proc_table.is_idle) {
         // schedule_user_process may have been called from proc_exit, which
-        // kills the process in curr_proc slot, so if that's the case,
+        // kills the process in curr_proc slot (and sets is_idle, in case the
+        // slot was taken by a new process since), so if that's the case,
         // pretend there wasn't any last_proc:
         last_proc = 0;
     }
-    if (proc_table.num_procs == 0) {
-        release(&proc_table.lock);
-        return;
+    if (last_proc != 0) {
+        last_proc->cpu_time += now - proc_table.switch_time;
     }
+    proc_table.switch_time = now;
+    perf_switch(last_proc);
 
     process_t *proc = find_ready_proc(curr_proc);
     if (!proc) {
@@ -64,63 +94,80 @@ void schedule_user_process() {
         // wrong, or all processes are sleeping. In which case we should simply
         // schedule the next timer tick and do nothing
         proc_table.is_idle = 1;
+        KSTAT_INC(idle);
+        KTRACE(KTRACE_EV_IDLE, last_proc ? last_proc->pid : -1, 0);
         release(&proc_table.lock);
-        set_timer_after(KERNEL_SCHEDULER_TICK_TIME);
+        set_timer_after(profile_timer_interval());
+        kstat_cpu_switch(KSTAT_CPU_IDLE);
         enable_interrupts();
         park_hart();
         return;
     }
-    acquire(&proc->lock);
-    proc->state = PROC_STATE_RUNNING;
+    acquire(PROC_LOCK(proc));
+    PROC_STATE(proc) = PROC_STATE_RUNNING;
+    vdso_set_running(proc->pid, now);
+    if (proc->ready_time != 0) {
+        schedlat_account(proc, now);
+    }
 
+    if (last_proc == 0 || last_proc->pid != proc->pid) {
+        KSTAT_INC(ctx_switches);
+        KTRACE(KTRACE_EV_SWITCH, last_proc ? last_proc->pid : -1, proc->pid);
+    }
     if (last_proc == 0) {
         copy_context(&trap_frame, &proc->context);
     } else if (last_proc->pid != proc->pid) {
         // the user process has changed: save the descending process's context
         // and load the ascending one's
-        acquire(&last_proc->lock);
+        acquire(PROC_LOCK(last_proc));
         copy_context(&last_proc->context, &trap_frame);
-        if (last_proc->state != PROC_STATE_SLEEPING) {
+        if (PROC_STATE(last_proc) != PROC_STATE_SLEEPING) {
             // restore last_proc to the ready state, but only if it's not sleeping
-            last_proc->state = PROC_STATE_READY;
+            PROC_STATE(last_proc) = PROC_STATE_READY;
         }
-        release(&last_proc->lock);
+        release(PROC_LOCK(last_proc));
         copy_context(&trap_frame, &proc->context);
     }
-    release(&proc->lock);
+    release(PROC_LOCK(proc));
     proc_table.is_idle = 0;
     release(&proc_table.lock);
     set_user_mode();
 }
 
 process_t* find_ready_proc(int curr_proc) {
+    // only the hot arrays in proc_table are looked at while scanning, the
+    // process_t itself is only touched once we've picked one:
+    uint64_t now = time_get_now();
     int orig_curr_proc = curr_proc;
-    process_t* proc = 0;
+    uint32_t state;
     do {
         curr_proc++;
-        if (curr_proc >= MAX_PROCS) {
+        if (curr_proc >= proc_table.capacity) {
             curr_proc = 0;
         }
-        proc = &proc_table.procs[curr_proc];
-        if (proc->state == PROC_STATE_READY) {
+        state = proc_table.states[curr_proc];
+        if (state == PROC_STATE_READY) {
             break;
         }
-        if (proc->state == PROC_STATE_SLEEPING && should_wake_up(proc)) {
-            proc->state = PROC_STATE_READY;
+        if (state == PROC_STATE_SLEEPING && should_wake_up(curr_proc, now)) {
+            state = PROC_STATE_READY;
+            proc_table.states[curr_proc] = state;
+            proc_table.procs[curr_proc]->ready_time = proc_table.wakeup_times[curr_proc];
+            KTRACE(KTRACE_EV_WAKEUP, proc_table.procs[curr_proc]->pid, 0);
             break;
         }
     } while (curr_proc != orig_curr_proc);
     proc_table.curr_proc = curr_proc;
-    if (proc->state == PROC_STATE_SLEEPING) {
+    if (state == PROC_STATE_SLEEPING) {
         // this can happen if all processes are sleeping
         return 0;
     }
-    return proc;
+    return proc_table.procs[curr_proc];
 }
 
-int should_wake_up(process_t* proc) {
-    uint64_t now = time_get_now();
-    if (proc->wakeup_time != 0 && proc->wakeup_time <= now) {
+int should_wake_up(int slot, uint64_t now) {
+    uint64_t wakeup_time = proc_table.wakeup_times[slot];
+    if (wakeup_time != 0 && wakeup_time <= now) {
         return 1;
     }
     return 0;
@@ -130,23 +177,26 @@ uint32_t proc_fork() {
     // allocate stack. Fail early if we're out of memory:
     void* sp = allocate_page();
     if (!sp) {
+        KSTAT_INC(fork_fails);
         // TODO: set errno
         return -1;
     }
 
     process_t* parent = myproc();
-    acquire(&parent->lock);
-    parent->context.pc = trap_frame.pc;
-    copy_context(&parent->context, &trap_frame);
-
+    // alloc_process() takes proc_table.lock, which comes before any process
+    // lock, so get the child before locking the parent:
     process_t* child = alloc_process();
     if (!child) {
+        KSTAT_INC(fork_fails);
         release_page(sp);
-        release(&parent->lock);
         return -1;
     }
-    child->pid = alloc_pid();
-    child->parent = parent;
+    acquire(PROC_LOCK(parent));
+    parent->context.pc = trap_frame.pc;
+    copy_context(&parent->context, &trap_frame);
+
+    child->ppid = parent->pid;
+    child->name = parent->name;
     child->context.pc = parent->context.pc;
     child->stack_page = sp;
     copy_page(child->stack_page, parent->stack_page);
@@ -157,10 +207,18 @@ uint32_t proc_fork() {
     child->context.regs[REG_SP] = (regsize_t)(sp + offset);
     offset = parent->context.regs[REG_FP] - (regsize_t)parent->stack_page;
     child->context.regs[REG_FP] = (regsize_t)(sp + offset);
+    // the ioring lives on the stack, so the child gets its own copy of it:
+    child->ioring = 0;
+    if (parent->ioring) {
+        offset = (regsize_t)parent->ioring - (regsize_t)parent->stack_page;
+        child->ioring = (ioring_t*)(sp + offset);
+    }
+    strace_fork(parent, child);
+    KTRACE(KTRACE_EV_FORK, parent->pid, child->pid);
     // child's return value should be a 0 pid:
     child->context.regs[REG_A0] = 0;
-    release(&parent->lock);
-    release(&child->lock);
+    release(PROC_LOCK(parent));
+    release(PROC_LOCK(child));
     trap_frame.regs[REG_A0] = child->pid;
     return child->pid;
 }
@@ -232,12 +290,14 @@ uint32_t proc_execv(char const* filename, char const* argv[]) {
         // TODO: set errno
         return -1;
     }
+    stack_paint(sp, sp + PAGE_SIZE);
     process_t* proc = myproc();
-    acquire(&proc->lock);
+    acquire(PROC_LOCK(proc));
     proc->context.pc = (regsize_t)program->entry_point;
     proc->name = program->name;
     release_page(proc->stack_page);
     proc->stack_page = sp;
+    proc->ioring = 0; // it was on the old stack
     regsize_t argc = len_argv(argv);
     sp_argv_t sp_argv = copy_argv(sp + PAGE_SIZE, argc, argv);
     proc->context.regs[REG_RA] = (regsize_t)proc->context.pc;
@@ -246,7 +306,7 @@ uint32_t proc_execv(char const* filename, char const* argv[]) {
     proc->context.regs[REG_A0] = argc;
     proc->context.regs[REG_A1] = sp_argv.new_argv;
     copy_context(&trap_frame, &proc->context);
-    release(&proc->lock);
+    release(PROC_LOCK(proc));
     // syscall() assigns whatever we return here to a0, the register that
     // contains the return value. But in case of exec, we don't really return
     // to the caller, we call the new program's main() instead, so we want a0
@@ -254,37 +314,104 @@ uint32_t proc_execv(char const* filename, char const* argv[]) {
     return argc;
 }
 
-// Let's start with a trivial implementation: a forever increasing counter.
+// Let's start with a trivial implementation: a forever increasing counter. It
+// doesn't need the proc_table.lock, an atomic increment is enough.
 uint32_t alloc_pid() {
-    acquire(&proc_table.lock);
-    uint32_t pid = proc_table.pid_counter;
-    proc_table.pid_counter++;
-    release(&proc_table.lock);
-    return pid;
+    return __sync_fetch_and_add(&proc_table.pid_counter, 1);
 }
 
 process_t* alloc_process() {
     acquire(&proc_table.lock);
-    for (int i = 0; i < MAX_PROCS; i++) {
-        if (i == proc_table.curr_proc) {
-            continue;
-        }
-        if (proc_table.procs[i].state == PROC_STATE_AVAILABLE) {
-            return init_proc(&proc_table.procs[i]);
+    int start = 0;
+    do {
+        for (int i = start; i < proc_table.capacity; i++) {
+            if (proc_table.states[i] == PROC_STATE_AVAILABLE) {
+                return init_proc(proc_table.procs[i]);
+            }
         }
-    }
+        // all slots are taken, only the newly added ones need to be looked at:
+        start = proc_table.capacity;
+    } while (grow_proc_table());
     // TODO: set errno
     release(&proc_table.lock);
     return 0;
 }
 
+_Static_assert(PROCS_PER_CHUNK > 0, "a process table chunk must fit a record");
+
+int grow_proc_table() {
+    if (proc_table.capacity >= MAX_PROCS) {
+        return 0;
+    }
+    process_t *chunk = (process_t*)allocate_pages(PROC_CHUNK_PAGES);
+    if (!chunk) {
+        return 0;
+    }
+    int old_capacity = proc_table.capacity;
+    for (int i = 0; i < PROCS_PER_CHUNK && proc_table.capacity < MAX_PROCS; i++) {
+        int slot = proc_table.capacity;
+        chunk[i].slot = slot;
+        proc_table.procs[slot] = &chunk[i];
+        proc_table.states[slot] = PROC_STATE_AVAILABLE;
+        proc_table.capacity++;
+    }
+    // alloc_process() retries for as long as the table grows, so never claim
+    // to have grown it without adding a slot:
+    return proc_table.capacity > old_capacity;
+}
+
+void pid_hash_insert(process_t* proc) {
+    uint32_t bucket = proc->pid % PID_HASH_SIZE;
+    proc->hash_next = proc_table.pid_hash[bucket];
+    proc_table.pid_hash[bucket] = proc->slot;
+}
+
+void pid_hash_remove(process_t* proc) {
+    int32_t *link = &proc_table.pid_hash[proc->pid % PID_HASH_SIZE];
+    while (*link != -1) {
+        process_t *p = proc_table.procs[*link];
+        if (p == proc) {
+            *link = proc->hash_next;
+            return;
+        }
+        link = &p->hash_next;
+    }
+}
+
+process_t* find_proc(uint32_t pid) {
+    int32_t slot = proc_table.pid_hash[pid % PID_HASH_SIZE];
+    while (slot != -1) {
+        process_t *proc = proc_table.procs[slot];
+        if (proc->pid == pid) {
+            return proc;
+        }
+        slot = proc->hash_next;
+    }
+    return 0;
+}
+
 process_t* init_proc(process_t* proc) {
-    acquire(&proc->lock);
-    proc->state = PROC_STATE_READY;
+    acquire(PROC_LOCK(proc));
+    PROC_STATE(proc) = PROC_STATE_READY;
+    PROC_PRIORITY(proc) = 0;
+    // the record may be recycled (or come straight from a fresh page), so
+    // don't leave anything dangling in it:
+    proc->name = 0;
+    proc->ppid = 0;
+    proc->stack_page = 0;
+    proc->cpu_time = 0;
+    proc->ioring = 0;
+    proc->traced = 0;
+    perf_reset(proc);
+    proc->ready_time = 0;
+    schedlat_reset(&proc->schedlat);
     for (int i = 0; i < MAX_PROC_FDS; i++) {
         proc->files[i] = 0;
     }
+    proc->pid = alloc_pid();
+    pid_hash_insert(proc);
     proc_table.num_procs++;
+    vdso_set_procs(proc_table.num_procs);
     release(&proc_table.lock);
     return proc;
 }
@@ -294,7 +421,7 @@ process_t* current_proc() {
     if (proc_table.num_procs == 0) {
         return 0;
     }
-    process_t* proc = &proc_table.procs[proc_table.curr_proc];
+    process_t* proc = proc_table.procs[proc_table.curr_proc];
     release(&proc_table.lock);
     return proc;
 }
@@ -309,34 +436,63 @@ process_t* myproc() {
 }
 
 void copy_context(trap_frame_t* dst, trap_frame_t* src) {
-    for (int i = 0; i < 32; i++) {
+    for (int i = 0; i < ARRAY_LENGTH(dst->regs); i++) {
         dst->regs[i] = src->regs[i];
     }
+    dst->pc = src->pc;
 }
 
 void proc_exit() {
     process_t* proc = myproc();
-    acquire(&proc->lock);
-    release_page(proc->stack_page);
-    proc->state = PROC_STATE_AVAILABLE;
-    acquire(&proc->parent->lock);
-    proc->parent->state = PROC_STATE_READY;
-    release(&proc->parent->lock);
-    release(&proc->lock);
-
+    // close whatever the process left open, a /proc file holds pages:
+    for (int i = FD_STDERR + 1; i < MAX_PROC_FDS; i++) {
+        if (proc->files[i]) {
+            fs_free_file(proc->files[i]);
+            proc->files[i] = 0;
+        }
+    }
+    // the slot must leave the pid hash before it's published as available,
+    // or alloc_process() could hand it out while find_proc() still finds the
+    // old pid in it:
     acquire(&proc_table.lock);
+    pid_hash_remove(proc);
     proc_table.num_procs--;
+    vdso_set_procs(proc_table.num_procs);
+    acquire(PROC_LOCK(proc));
+    release_page(proc->stack_page);
+    strace_exit(proc);
+    PROC_STATE(proc) = PROC_STATE_AVAILABLE;
+    KTRACE(KTRACE_EV_EXIT, proc->pid, 0);
+    // the parent may be gone already (and init has none, its ppid is its own
+    // pid, which has just been unhashed):
+    process_t *parent = find_proc(proc->ppid);
+    if (parent) {
+        acquire(PROC_LOCK(parent));
+    }
+    perf_exit(proc, parent);
+    if (parent) {
+        if (PROC_STATE(parent) == PROC_STATE_SLEEPING) {
+            parent->ready_time = time_get_now();
+            KTRACE(KTRACE_EV_WAKEUP, parent->pid, 0);
+        }
+        PROC_STATE(parent) = PROC_STATE_READY;
+        release(PROC_LOCK(parent));
+    }
+    release(PROC_LOCK(proc));
+    // the slot may be reused as soon as the lock is released, so make sure
+    // schedule_user_process() doesn't save the trap frame into it:
+    proc_table.is_idle = 1;
     release(&proc_table.lock);
     schedule_user_process();
 }
 
 int32_t wait_or_sleep(uint64_t wakeup_time) {
     process_t* proc = myproc();
-    acquire(&proc->lock);
-    proc->state = PROC_STATE_SLEEPING;
-    proc->wakeup_time = wakeup_time;
+    acquire(PROC_LOCK(proc));
+    PROC_STATE(proc) = PROC_STATE_SLEEPING;
+    PROC_WAKEUP_TIME(proc) = wakeup_time;
     copy_context(&proc->context, &trap_frame); // save the context before sleep
-    release(&proc->lock);
+    release(PROC_LOCK(proc));
     schedule_user_process();
     return 0;
 }
@@ -357,14 +513,14 @@ uint32_t proc_plist(uint32_t *pids, uint32_t size) {
     }
     int p = 0;
     acquire(&proc_table.lock);
-    for (int i = 0; i < MAX_PROCS; i++) {
+    for (int i = 0; i < proc_table.capacity; i++) {
         if (p >= size) {
             // TODO: set errno to indicate that size was too small
             release(&proc_table.lock);
             return -1;
         }
-        if (proc_table.procs[i].state != PROC_STATE_AVAILABLE) {
-            pids[p] = proc_table.procs[i].pid;
+        if (proc_table.states[i] != PROC_STATE_AVAILABLE) {
+            pids[p] = proc_table.procs[i]->pid;
             p++;
         }
     }
@@ -372,24 +528,158 @@ uint32_t proc_plist(uint32_t *pids, uint32_t size) {
     return p;
 }
 
+uint32_t proc_stack_max(process_t *proc) {
+    if (!proc->stack_page) {
+        return 0;
+    }
+    return stack_max_depth(proc->stack_page, proc->stack_page + PAGE_SIZE);
+}
+
 uint32_t proc_pinfo(uint32_t pid, pinfo_t *pinfo) {
     if (!pinfo) {
         return -1;
     }
     acquire(&proc_table.lock);
-    for (int i = 0; i < MAX_PROCS; i++) {
-        process_t *proc = &proc_table.procs[i];
-        if (proc->pid == pid) {
-            acquire(&proc->lock);
-            pinfo->pid = proc->pid;
-            strncpy(pinfo->name, proc->name, 16);
-            pinfo->state = proc->state;
-            release(&proc->lock);
-            break;
+    process_t *proc = find_proc(pid);
+    if (proc) {
+        acquire(PROC_LOCK(proc));
+        pinfo->pid = proc->pid;
+        strncpy(pinfo->name, proc->name, 16);
+        pinfo->state = PROC_STATE(proc);
+        pinfo->stack_max = proc_stack_max(proc);
+        release(PROC_LOCK(proc));
+    }
+    release(&proc_table.lock);
+    return proc ? 0 : -1;
+}
+
+int32_t proc_trace(uint32_t pid, uint32_t enable) {
+    acquire(&proc_table.lock);
+    process_t *proc = pid ? find_proc(pid)
+                          : proc_table.procs[proc_table.curr_proc];
+    if (proc) {
+        acquire(PROC_LOCK(proc));
+        strace_enable(proc, enable);
+        release(PROC_LOCK(proc));
+    }
+    release(&proc_table.lock);
+    return proc ? 0 : -1;
+}
+
+int32_t proc_perfstat(uint32_t pid, perf_stat_t *stat) {
+    acquire(&proc_table.lock);
+    process_t *proc = pid ? find_proc(pid)
+                          : proc_table.procs[proc_table.curr_proc];
+    if (proc) {
+        acquire(PROC_LOCK(proc));
+        if (!pid) {
+            // bring our own counters up to date:
+            perf_switch(proc);
         }
+        perf_stat(proc, stat);
+        release(PROC_LOCK(proc));
     }
     release(&proc_table.lock);
-    return 0;
+    return proc ? 0 : -1;
+}
+
+void schedlat_reset(schedlat_t *lat) {
+    lat->count = 0;
+    lat->max_us = 0;
+    lat->total_us = 0;
+    for (int i = 0; i < SCHEDLAT_BUCKETS; i++) {
+        lat->buckets[i] = 0;
+    }
+}
+
+void schedlat_add(schedlat_t *lat, uint32_t us) {
+    // the bucket is the number of significant bits in us:
+    uint32_t bucket = 0;
+    while (bucket < SCHEDLAT_BUCKETS - 1 && (us >> bucket) != 0) {
+        bucket++;
+    }
+    lat->buckets[bucket]++;
+    lat->count++;
+    lat->total_us += us;
+    if (us > lat->max_us) {
+        lat->max_us = us;
+    }
+}
+
+void schedlat_account(process_t *proc, uint64_t now) {
+    uint64_t delay = 0;
+    if (now > proc->ready_time) {
+        delay = now - proc->ready_time;
+    }
+    uint64_t us = udiv64(delay * 1000000, ONE_SECOND);
+    if (us > 0xffffffff) {
+        us = 0xffffffff;
+    }
+    schedlat_add(&proc->schedlat, us);
+    schedlat_add(&proc_table.schedlat, us);
+    proc->ready_time = 0;
+}
+
+void schedlat_copy(schedlat_t *dst, schedlat_t *src) {
+    dst->count = src->count;
+    dst->max_us = src->max_us;
+    dst->total_us = src->total_us;
+    for (int i = 0; i < SCHEDLAT_BUCKETS; i++) {
+        dst->buckets[i] = src->buckets[i];
+    }
+}
+
+int32_t proc_schedlat(uint32_t pid, schedlat_t *lat) {
+    acquire(&proc_table.lock);
+    if (pid == SCHEDLAT_ALL) {
+        schedlat_copy(lat, &proc_table.schedlat);
+        release(&proc_table.lock);
+        return 0;
+    }
+    process_t *proc = pid ? find_proc(pid)
+                          : proc_table.procs[proc_table.curr_proc];
+    if (proc) {
+        acquire(PROC_LOCK(proc));
+        schedlat_copy(lat, &proc->schedlat);
+        release(PROC_LOCK(proc));
+    }
+    release(&proc_table.lock);
+    return proc ? 0 : -1;
+}
+
+uint32_t proc_psnap(pstat_t *buf, uint32_t size, uint32_t skip) {
+    if (!buf) {
+        return -1;
+    }
+    uint64_t now = time_get_now();
+    uint32_t n = 0;
+    acquire(&proc_table.lock);
+    for (int i = 0; i < proc_table.capacity; i++) {
+        if (proc_table.states[i] == PROC_STATE_AVAILABLE) {
+            continue;
+        }
+        if (n >= skip && n - skip < size) {
+            process_t *proc = proc_table.procs[i];
+            pstat_t *ps = &buf[n - skip];
+            acquire(PROC_LOCK(proc));
+            ps->pid = proc->pid;
+            ps->ppid = proc->ppid;
+            ps->state = proc_table.states[i];
+            ps->pages = proc->stack_page ? 1 : 0;
+            ps->cpu_time = proc->cpu_time;
+            if (i == proc_table.curr_proc && !proc_table.is_idle) {
+                // the running process hasn't been charged for its current slice yet
+                ps->cpu_time += now - proc_table.switch_time;
+            }
+            ps->wakeup_time = proc_table.wakeup_times[i];
+            ps->stack_max = proc_stack_max(proc);
+            strncpy(ps->name, proc->name ? proc->name : "", 16);
+            release(PROC_LOCK(proc));
+        }
+        n++;
+    }
+    release(&proc_table.lock);
+    return n;
 }
 
 int32_t fd_alloc(process_t *proc, file_t *f) {
@@ -412,30 +702,31 @@ int32_t proc_open(char const *filepath, uint32_t flags) {
         // TODO: set errno to indicate out of global files
         return -1;
     }
+    // open before taking the process lock: opening a /proc file generates it,
+    // and the generators take proc_table.lock and the process locks.
+    int32_t status = fs_open(f, filepath, flags);
+    if (status != 0) {
+        fs_free_file(f);
+        // TODO: set errno to status
+        return -1;
+    }
     process_t* proc = myproc();
-    acquire(&proc->lock);
+    acquire(PROC_LOCK(proc));
     int32_t fd = fd_alloc(proc, f);
+    release(PROC_LOCK(proc));
     if (fd < 0) {
         // TODO: set errno to indicate out of proc FDs
-        release(&proc->lock);
-        return -1;
-    }
-    int32_t status = fs_open(f, filepath, flags);
-    if (status != 0) {
-        proc->files[fd] = 0;
-        // TODO: set errno to status
-        release(&proc->lock);
+        fs_free_file(f);
         return -1;
     }
-    release(&proc->lock);
     return fd;
 }
 
 int32_t proc_read(uint32_t fd, void *buf, uint32_t size) {
     process_t* proc = myproc();
-    acquire(&proc->lock);
+    acquire(PROC_LOCK(proc));
     file_t *f = proc->files[fd];
-    release(&proc->lock);
+    release(PROC_LOCK(proc));
     if (f == 0) {
         // Reading a non-open file. TODO: set errno
         return -1;
@@ -449,15 +740,48 @@ int32_t proc_close(uint32_t fd) {
         return -1;
     }
     process_t* proc = myproc();
-    acquire(&proc->lock);
+    acquire(PROC_LOCK(proc));
     // TODO: flush when we have any buffering
     file_t *f = proc->files[fd];
     if (f == 0) {
         // Closing a non-open file. TODO: set errno
-        release(&proc->lock);
+        release(PROC_LOCK(proc));
         return -1;
     }
     fs_free_file(f);
     fd_free(proc, fd);
-    release(&proc->lock);
+    release(PROC_LOCK(proc));
+}
+
+uint32_t calc_load(uint32_t load, uint32_t exp, uint32_t active) {
+    uint32_t newload = load * exp + active * (FIXED_1 - exp);
+    if (active >= load) {
+        newload += FIXED_1 - 1; // round up, so that the average can reach active
+    }
+    return newload / FIXED_1;
+}
+
+void proc_calc_load() {
+    uint64_t now = time_get_now();
+    acquire(&proc_table.lock);
+    if (now < proc_table.next_load_time) {
+        release(&proc_table.lock);
+        return;
+    }
+    uint32_t active = 0;
+    for (int i = 0; i < proc_table.capacity; i++) {
+        uint32_t state = proc_table.states[i];
+        if (state == PROC_STATE_READY || state == PROC_STATE_RUNNING) {
+            active++;
+        }
+    }
+    active *= FIXED_1;
+    // catch up on any updates we've missed, e.g. with a long sched.tick:
+    while (proc_table.next_load_time <= now) {
+        proc_table.loadavg[0] = calc_load(proc_table.loadavg[0], EXP_1, active);
+        proc_table.loadavg[1] = calc_load(proc_table.loadavg[1], EXP_5, active);
+        proc_table.loadavg[2] = calc_load(proc_table.loadavg[2], EXP_15, active);
+        proc_table.next_load_time += LOAD_FREQ;
+    }
+    release(&proc_table.lock);
 }
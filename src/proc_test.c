@@ -4,6 +4,8 @@
 #include "string.h"
 #include "pagealloc.h"
 #include "programs.h"
+#include "kbench.h"
+#include "stackmark.h"
 
 // defined in userland.c:
 extern int u_main_init();
@@ -20,6 +22,20 @@ extern int u_main_hanger();
 extern int u_main_ps();
 extern int u_main_cat();
 extern int u_main_coma();
+extern int u_main_sysctl();
+extern int u_main_strace();
+extern int u_main_prof();
+extern int u_main_perf();
+extern int u_main_ktrace();
+extern int u_main_schedlat();
+extern int u_main_vmstat();
+extern int u_main_top();
+
+// defined in user-bench.c:
+extern int u_main_ubench();
+
+// defined in user-cyclictest.c:
+extern int u_main_cyclictest();
 
 user_program_t userland_programs[MAX_USERLAND_PROGS] _rodata = {
     (user_program_t){
@@ -62,6 +78,46 @@ user_program_t userland_programs[MAX_USERLAND_PROGS] _rodata = {
         .entry_point = &u_main_coma,
         .name = "coma",
     },
+    (user_program_t){
+        .entry_point = &u_main_sysctl,
+        .name = "sysctl",
+    },
+    (user_program_t){
+        .entry_point = &u_main_strace,
+        .name = "strace",
+    },
+    (user_program_t){
+        .entry_point = &u_main_prof,
+        .name = "prof",
+    },
+    (user_program_t){
+        .entry_point = &u_main_perf,
+        .name = "perf",
+    },
+    (user_program_t){
+        .entry_point = &u_main_ktrace,
+        .name = "ktrace",
+    },
+    (user_program_t){
+        .entry_point = &u_main_schedlat,
+        .name = "schedlat",
+    },
+    (user_program_t){
+        .entry_point = &u_main_vmstat,
+        .name = "vmstat",
+    },
+    (user_program_t){
+        .entry_point = &u_main_top,
+        .name = "top",
+    },
+    (user_program_t){
+        .entry_point = &u_main_ubench,
+        .name = "ubench",
+    },
+    (user_program_t){
+        .entry_point = &u_main_cyclictest,
+        .name = "cyclictest",
+    },
     // keep this last, it's a sentinel:
     (user_program_t){
         .entry_point = 0,
@@ -70,11 +126,23 @@ user_program_t userland_programs[MAX_USERLAND_PROGS] _rodata = {
 };
 
 void init_test_processes() {
-    if (!strncmp(fdt_get_bootargs(), "dry-run", ARRAY_LENGTH("dry-run"))) {
+    if (fdt_has_bootarg("dry-run")) {
+        return;
+    }
+    if (fdt_has_bootarg("bench")) {
+        kbench_run_all(); // powers off when done
         return;
     }
-    if (!strncmp(fdt_get_bootargs(), "smoke-test", ARRAY_LENGTH("smoke-test"))) {
+    if (fdt_has_bootarg("smoke-test")) {
         assign_init_program("smoke-test");
+    } else if (fdt_has_bootarg("ubench")) {
+        assign_init_program("ubench");
+    } else if (fdt_has_bootarg("prof")) {
+        assign_init_program("prof");
+    } else if (fdt_has_bootarg("ktrace")) {
+        assign_init_program("ktrace");
+    } else if (fdt_has_bootarg("cyclictest")) {
+        assign_init_program("cyclictest");
     } else {
         assign_init_program("sh");
     }
@@ -82,19 +150,26 @@ void init_test_processes() {
 
 void assign_init_program(char const* prog) {
     user_program_t *program = find_user_program(prog);
-    proc_table.num_procs = 1;
-    process_t* p0 = &proc_table.procs[0];
-    p0->pid = alloc_pid();
+    acquire(&proc_table.lock);
+    if (!grow_proc_table()) {
+        // TODO: panic
+        release(&proc_table.lock);
+        return;
+    }
+    // init_proc releases proc_table.lock and leaves us holding p0's lock:
+    process_t* p0 = init_proc(proc_table.procs[0]);
     p0->context.pc = (regsize_t)program->entry_point;
     p0->name = program->name;
-    p0->state = PROC_STATE_READY;
     void* sp = allocate_page();
     if (!sp) {
         // TODO: panic
+        release(PROC_LOCK(p0));
         return;
     }
+    stack_paint(sp, sp + PAGE_SIZE);
     p0->stack_page = sp;
     p0->context.regs[REG_SP] = (regsize_t)(sp + PAGE_SIZE);
+    release(PROC_LOCK(p0));
 }
 
 user_program_t* find_user_program(char const *name) {
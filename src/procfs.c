@@ -0,0 +1,337 @@
+#include "procfs.h"
+#include "proc.h"
+#include "pagealloc.h"
+#include "kernel.h"
+#include "string.h"
+#include "div64.h"
+#include "sysctl.h"
+#include "profile.h"
+#include "ktrace.h"
+#include "stackmark.h"
+#include "kstat.h"
+
+void procfs_gen_meminfo(procfs_buf_t *buf, uint32_t pid);
+void procfs_gen_sched(procfs_buf_t *buf, uint32_t pid);
+void procfs_gen_sys(procfs_buf_t *buf, uint32_t pid);
+void procfs_gen_profile(procfs_buf_t *buf, uint32_t pid);
+void procfs_gen_ktrace(procfs_buf_t *buf, uint32_t pid);
+void procfs_gen_stacks(procfs_buf_t *buf, uint32_t pid);
+void procfs_gen_stat(procfs_buf_t *buf, uint32_t pid);
+void procfs_gen_pid_stat(procfs_buf_t *buf, uint32_t pid);
+
+// procfs_entries lists the files in /proc itself. Keep the sentinel last.
+procfs_entry_t procfs_entries[] _rodata = {
+    { .name = "meminfo", .gen = procfs_gen_meminfo },
+    { .name = "sched",   .gen = procfs_gen_sched },
+    { .name = "sys",     .gen = procfs_gen_sys,    .size = PROCFS_SYS_SIZE },
+    { .name = "profile", .gen = procfs_gen_profile },
+    { .name = "ktrace",  .gen = procfs_gen_ktrace },
+    { .name = "stacks",  .gen = procfs_gen_stacks, .size = PROCFS_STACKS_SIZE },
+    { .name = "stat",    .gen = procfs_gen_stat },
+    { .name = 0,         .gen = 0 },
+};
+
+// procfs_pid_entries lists the files in each /proc/<pid>/ directory. Keep the
+// sentinel last.
+procfs_entry_t procfs_pid_entries[] _rodata = {
+    { .name = "stat", .gen = procfs_gen_pid_stat },
+    { .name = 0,      .gen = 0 },
+};
+
+int procfs_owns_path(char const *filepath) {
+    return !strncmp(filepath, PROCFS_MOUNT_POINT, ARRAY_LENGTH(PROCFS_MOUNT_POINT) - 1);
+}
+
+procfs_entry_t* procfs_find_entry(procfs_entry_t *entries, char const *name) {
+    for (int i = 0; entries[i].name; i++) {
+        if (!strncmp(entries[i].name, name, PROCFS_MAX_NAME_LEN)) {
+            return &entries[i];
+        }
+    }
+    return 0;
+}
+
+// procfs_parse_pid parses a decimal pid at the start of path and returns the
+// index just past it, or -1 if path doesn't start with a number.
+int procfs_parse_pid(char const *path, uint32_t *pid) {
+    int i = 0;
+    *pid = 0;
+    while (path[i] >= '0' && path[i] <= '9') {
+        *pid = *pid * 10 + (path[i] - '0');
+        i++;
+    }
+    return i > 0 ? i : -1;
+}
+
+int32_t procfs_open(file_t *f, char const *filepath, uint32_t flags) {
+    char const *name = filepath + ARRAY_LENGTH(PROCFS_MOUNT_POINT) - 1;
+    procfs_entry_t *entry = 0;
+    uint32_t pid = 0;
+    int end = procfs_parse_pid(name, &pid);
+    if (end > 0 && name[end] == '/') {
+        acquire(&proc_table.lock);
+        process_t *proc = find_proc(pid);
+        release(&proc_table.lock);
+        if (!proc) {
+            // TODO: errno = ENOENT
+            return -1;
+        }
+        entry = procfs_find_entry(procfs_pid_entries, name + end + 1);
+    } else {
+        entry = procfs_find_entry(procfs_entries, name);
+    }
+    if (!entry) {
+        // TODO: errno = ENOENT
+        return -1;
+    }
+    uint32_t size = entry->size ? entry->size : PAGE_SIZE - sizeof(procfs_buf_t);
+    uint32_t npages = (sizeof(procfs_buf_t) + size + PAGE_SIZE - 1) / PAGE_SIZE;
+    procfs_buf_t *pbuf = allocate_pages(npages);
+    if (!pbuf) {
+        // TODO: errno = ENOMEM
+        return -1;
+    }
+    pbuf->len = 0;
+    pbuf->size = npages * PAGE_SIZE - sizeof(procfs_buf_t);
+    pbuf->truncated = 0;
+    entry->gen(pbuf, pid);
+    f->flags |= FFLAGS_READABLE | FFLAGS_PROCFS_FILE;
+    f->fs_file = pbuf;
+    f->fs_id = pid;
+    f->read = procfs_read;
+    f->write = procfs_write;
+    f->close = procfs_close;
+    return 0;
+}
+
+int32_t procfs_read(file_t *f, uint32_t pos, void *buf, uint32_t size) {
+    procfs_buf_t *pbuf = (procfs_buf_t*)f->fs_file;
+    char *cbuf = (char*)buf;
+    int i = 0;
+    while (i < size && pos + i < pbuf->len) {
+        cbuf[i] = pbuf->data[pos + i];
+        i++;
+    }
+    return i;
+}
+
+int32_t procfs_write(file_t *f, uint32_t pos, void *buf, uint32_t nbytes) {
+    return -1; // all of /proc is read-only
+}
+
+void procfs_close(file_t *f) {
+    procfs_buf_t *pbuf = (procfs_buf_t*)f->fs_file;
+    uint32_t npages = (sizeof(procfs_buf_t) + pbuf->size) / PAGE_SIZE;
+    for (uint32_t i = 0; i < npages; i++) {
+        release_page((char*)pbuf + i * PAGE_SIZE);
+    }
+}
+
+void procfs_puts(procfs_buf_t *buf, char const *str) {
+    if (buf->truncated) {
+        return;
+    }
+    // keep room for the mark, in case what follows doesn't fit:
+    uint32_t limit = buf->size - (ARRAY_LENGTH(PROCFS_TRUNC_MARK) - 1);
+    while (*str && buf->len < limit) {
+        buf->data[buf->len++] = *str++;
+    }
+    if (*str) {
+        char const *mark = PROCFS_TRUNC_MARK;
+        while (*mark) {
+            buf->data[buf->len++] = *mark++;
+        }
+        buf->truncated = 1;
+    }
+}
+
+void procfs_putu(procfs_buf_t *buf, uint64_t num) {
+    char digits[24];
+    int i = ARRAY_LENGTH(digits) - 1;
+    digits[i] = 0;
+    do {
+        uint32_t digit;
+        num = udivmod64(num, 10, &digit);
+        digits[--i] = '0' + digit;
+    } while (num > 0);
+    procfs_puts(buf, &digits[i]);
+}
+
+void procfs_put_kv(procfs_buf_t *buf, char const *key, uint64_t value) {
+    procfs_puts(buf, key);
+    procfs_puts(buf, " ");
+    procfs_putu(buf, value);
+    procfs_puts(buf, "\n");
+}
+
+void procfs_gen_meminfo(procfs_buf_t *buf, uint32_t pid) {
+    acquire(&paged_memory.lock);
+    uint32_t total = paged_memory.num_pages;
+    uint32_t free = count_free_pages();
+    release(&paged_memory.lock);
+    procfs_put_kv(buf, "page_size", PAGE_SIZE);
+    procfs_put_kv(buf, "pages_total", total);
+    procfs_put_kv(buf, "pages_free", free);
+}
+
+void procfs_gen_sched(procfs_buf_t *buf, uint32_t pid) {
+    acquire(&proc_table.lock);
+    uint32_t num_procs = proc_table.num_procs;
+    uint32_t capacity = proc_table.capacity;
+    uint32_t idle = proc_table.is_idle;
+    uint32_t curr_pid = 0;
+    if (!idle && num_procs > 0) {
+        curr_pid = proc_table.procs[proc_table.curr_proc]->pid;
+    }
+    uint32_t ready = 0;
+    uint32_t sleeping = 0;
+    for (int i = 0; i < proc_table.capacity; i++) {
+        uint32_t state = proc_table.states[i];
+        if (state == PROC_STATE_READY || state == PROC_STATE_RUNNING) {
+            ready++;
+        } else if (state == PROC_STATE_SLEEPING) {
+            sleeping++;
+        }
+    }
+    release(&proc_table.lock);
+    procfs_put_kv(buf, "procs", num_procs);
+    procfs_put_kv(buf, "procs_runnable", ready);
+    procfs_put_kv(buf, "procs_sleeping", sleeping);
+    procfs_put_kv(buf, "table_capacity", capacity);
+    procfs_put_kv(buf, "idle", idle);
+    procfs_put_kv(buf, "curr_pid", curr_pid);
+    procfs_put_kv(buf, "tick", sched_tick_time);
+}
+
+void procfs_gen_sys(procfs_buf_t *buf, uint32_t pid) {
+    acquire(&sysctl_table.lock);
+    for (int i = 0; i < sysctl_table.num_entries; i++) {
+        sysctl_t *entry = &sysctl_table.entries[i];
+        procfs_put_kv(buf, entry->name, *entry->value);
+    }
+    release(&sysctl_table.lock);
+}
+
+void procfs_gen_profile(procfs_buf_t *buf, uint32_t pid) {
+    uint32_t dropped = profile_dropped();
+    procfs_put_kv(buf, "enable", profile.enable);
+    procfs_put_kv(buf, "interval", profile.interval);
+    procfs_put_kv(buf, "samples", profile.total);
+    procfs_put_kv(buf, "dropped", dropped);
+}
+
+void procfs_gen_ktrace(procfs_buf_t *buf, uint32_t pid) {
+    procfs_put_kv(buf, "enable", ktrace.enable);
+    procfs_put_kv(buf, "mask", ktrace.mask);
+    procfs_put_kv(buf, "dropped", ktrace_dropped());
+}
+
+// procfs_gen_stacks reports the stack high-water marks, in bytes: a line per
+// hart for the kernel stacks, and one per process for their stack pages,
+// keyed by pid. Harts whose stack is still all paint never ran and are left
+// out.
+void procfs_gen_stacks(procfs_buf_t *buf, uint32_t pid) {
+    procfs_put_kv(buf, "kstack_size", KSTACK_SIZE);
+    for (uint32_t hart = 0; hart < num_harts; hart++) {
+        uint32_t depth = kstack_max_depth(hart);
+        if (depth == 0) {
+            continue;
+        }
+        procfs_puts(buf, "kstack");
+        procfs_putu(buf, hart);
+        procfs_puts(buf, " ");
+        procfs_putu(buf, depth);
+        procfs_puts(buf, "\n");
+    }
+    procfs_put_kv(buf, "ustack_size", PAGE_SIZE);
+    acquire(&proc_table.lock);
+    for (int i = 0; i < proc_table.capacity; i++) {
+        if (proc_table.states[i] == PROC_STATE_AVAILABLE) {
+            continue;
+        }
+        process_t *proc = proc_table.procs[i];
+        acquire(PROC_LOCK(proc));
+        procfs_puts(buf, "ustack");
+        procfs_putu(buf, proc->pid);
+        procfs_puts(buf, " ");
+        procfs_putu(buf, proc_stack_max(proc));
+        procfs_puts(buf, "\n");
+        release(PROC_LOCK(proc));
+    }
+    release(&proc_table.lock);
+}
+
+void procfs_put_cpu_times(procfs_buf_t *buf, uint64_t *times) {
+    for (int i = 0; i < KSTAT_CPU_STATES; i++) {
+        procfs_puts(buf, " ");
+        procfs_putu(buf, times[i]);
+    }
+    procfs_puts(buf, "\n");
+}
+
+// procfs_gen_stat reports the time spent in each KSTAT_CPU_* state, in
+// timer ticks, like /proc/stat on Linux: a 'cpu user kernel irq idle' line
+// summed over all harts, then a 'cpuN ...' line for each hart. Parked harts
+// don't account their time, so they have no line.
+void procfs_gen_stat(procfs_buf_t *buf, uint32_t pid) {
+    uint64_t times[KSTAT_CPU_STATES];
+    kstat_cpu_sum(times);
+    procfs_puts(buf, "cpu");
+    procfs_put_cpu_times(buf, times);
+    for (uint32_t hart = 0; hart < num_harts; hart++) {
+        if (kstat_cpu_read(hart, times) != 0) {
+            continue;
+        }
+        procfs_puts(buf, "cpu");
+        procfs_putu(buf, hart);
+        procfs_put_cpu_times(buf, times);
+    }
+}
+
+char procfs_state_char(uint32_t state) {
+    switch (state) {
+        case PROC_STATE_AVAILABLE: return 'A';
+        case PROC_STATE_READY:     return 'G';
+        case PROC_STATE_RUNNING:   return 'R';
+        case PROC_STATE_SLEEPING:  return 'S';
+    }
+    return 'U';
+}
+
+// procfs_gen_pid_stat generates a single line with space-separated fields:
+// pid (name) state ppid pages cpu_time wakeup_time
+void procfs_gen_pid_stat(procfs_buf_t *buf, uint32_t pid) {
+    char name[PROCFS_MAX_NAME_LEN];
+    char state[3] = {' ', 0, 0};
+    acquire(&proc_table.lock);
+    process_t *proc = find_proc(pid);
+    if (!proc) {
+        // the process has exited since the file was opened
+        release(&proc_table.lock);
+        return;
+    }
+    acquire(PROC_LOCK(proc));
+    uint32_t ppid = proc->ppid;
+    uint32_t pages = proc->stack_page ? 1 : 0;
+    uint64_t cpu_time = proc->cpu_time;
+    uint64_t wakeup_time = PROC_WAKEUP_TIME(proc);
+    state[1] = procfs_state_char(PROC_STATE(proc));
+    strncpy(name, proc->name ? proc->name : "", ARRAY_LENGTH(name));
+    name[ARRAY_LENGTH(name) - 1] = 0;
+    release(PROC_LOCK(proc));
+    release(&proc_table.lock);
+    procfs_putu(buf, pid);
+    procfs_puts(buf, " (");
+    procfs_puts(buf, name);
+    procfs_puts(buf, ")");
+    procfs_puts(buf, state);
+    procfs_puts(buf, " ");
+    procfs_putu(buf, ppid);
+    procfs_puts(buf, " ");
+    procfs_putu(buf, pages);
+    procfs_puts(buf, " ");
+    procfs_putu(buf, cpu_time);
+    procfs_puts(buf, " ");
+    procfs_putu(buf, wakeup_time);
+    procfs_puts(buf, "\n");
+}
@@ -0,0 +1,117 @@
+#include "profile.h"
+#include "kernel.h"
+#include "proc.h"
+#include "sysctl.h"
+
+profile_t profile;
+
+void profile_init() {
+    profile.lock = 0;
+    profile.enable = 0;
+    profile.interval = PROFILE_INTERVAL_DEFAULT;
+    profile.running = 0;
+    profile.total = 0;
+    for (int i = 0; i < MAX_HARTS; i++) {
+        profile.harts[i].num_samples = 0;
+        profile.harts[i].dropped = 0;
+        profile.harts[i].next_sched = 0;
+    }
+    sysctl_register("prof.enable", SYSCTL_TYPE_BOOL, &profile.enable, 0, 1);
+    sysctl_register("prof.interval", SYSCTL_TYPE_UINT, &profile.interval,
+                    PROFILE_INTERVAL_MIN, PROFILE_INTERVAL_MAX);
+}
+
+// profile_start resets the buffers when profiling gets enabled, so that a
+// session doesn't see the leftovers of the previous one. Should be called with
+// profile.lock held.
+void profile_start(uint64_t now) {
+    profile.total = 0;
+    for (int i = 0; i < MAX_HARTS; i++) {
+        profile.harts[i].num_samples = 0;
+        profile.harts[i].dropped = 0;
+        profile.harts[i].next_sched = now;
+    }
+    profile.running = 1;
+}
+
+int profile_tick(regsize_t pc, uint32_t pid, uint32_t flags) {
+    if (!profile.enable) {
+        profile.running = 0;
+        return 0;
+    }
+    uint64_t now = time_get_now();
+    uint32_t hart = get_mhartid();
+    acquire(&profile.lock);
+    if (!profile.running) {
+        profile_start(now);
+    }
+    profile_buf_t *buf = &profile.harts[hart];
+    profile.total++;
+    if (buf->num_samples < PROFILE_SAMPLES) {
+        prof_sample_t *sample = &buf->samples[buf->num_samples++];
+        sample->pc = pc;
+        sample->pid = pid;
+        sample->hart = hart;
+        sample->flags = flags;
+    } else {
+        buf->dropped++;
+    }
+    int sample_only = now < buf->next_sched;
+    if (sample_only) {
+        uint64_t left = buf->next_sched - now;
+        set_timer_after(left < profile.interval ? left : profile.interval);
+    } else {
+        buf->next_sched = now + sched_tick_time;
+    }
+    release(&profile.lock);
+    return sample_only;
+}
+
+uint64_t profile_timer_interval() {
+    if (profile.enable && profile.interval < sched_tick_time) {
+        return profile.interval;
+    }
+    return sched_tick_time;
+}
+
+uint32_t profile_read(prof_sample_t *buf, uint32_t size) {
+    uint32_t n = 0;
+    acquire(&profile.lock);
+    for (int i = 0; i < MAX_HARTS && n < size; i++) {
+        profile_buf_t *hbuf = &profile.harts[i];
+        uint32_t count = hbuf->num_samples;
+        if (count > size - n) {
+            count = size - n;
+        }
+        for (uint32_t j = 0; j < count; j++) {
+            prof_sample_t *src = &hbuf->samples[j];
+            buf[n].pc = src->pc;
+            buf[n].pid = src->pid;
+            buf[n].hart = src->hart;
+            buf[n].flags = src->flags;
+            n++;
+        }
+        // shift the unread samples to the front of the buffer:
+        for (uint32_t j = count; j < hbuf->num_samples; j++) {
+            prof_sample_t *src = &hbuf->samples[j];
+            prof_sample_t *dst = &hbuf->samples[j - count];
+            dst->pc = src->pc;
+            dst->pid = src->pid;
+            dst->hart = src->hart;
+            dst->flags = src->flags;
+        }
+        hbuf->num_samples -= count;
+    }
+    release(&profile.lock);
+    return n;
+}
+
+uint32_t profile_dropped() {
+    uint32_t dropped = 0;
+    acquire(&profile.lock);
+    for (int i = 0; i < MAX_HARTS; i++) {
+        dropped += profile.harts[i].dropped;
+    }
+    release(&profile.lock);
+    return dropped;
+}
@@ -50,6 +50,15 @@ void set_pmpaddr3(void* addr) {
     );
 }
 
+void set_pmpaddr4(void* addr) {
+    addr = shift_right_addr(addr, 2);
+    asm volatile (
+        "csrw   pmpaddr4, %0;"  // set pmpaddr4 to the requested addr
+        :                       // no output
+        : "r"(addr)             // input in addr
+    );
+}
+
 void set_pmpcfg0(unsigned long value) {
     asm volatile (
         "csrw   pmpcfg0, %0;"   // set pmpcfg0 to the requested value
@@ -58,6 +67,24 @@ void set_pmpcfg0(unsigned long value) {
     );
 }
 
+#if XLEN == 32
+void set_pmpcfg1(unsigned long value) {
+    asm volatile (
+        "csrw   pmpcfg1, %0;"   // set pmpcfg1 to the requested value
+        :                       // no output
+        : "r"(value)            // input in value
+    );
+}
+#endif
+
+void set_mcounteren(unsigned int value) {
+    asm volatile (
+        "csrs   mcounteren, %0;" // set the requested bits in mcounteren
+        :                        // no output
+        : "r"(value)             // input in value
+    );
+}
+
 unsigned int get_mstatus() {
     register unsigned int a0 asm ("a0");
     asm volatile (
@@ -121,3 +148,45 @@ uint64_t time_get_now() {
     uint64_t *mtime = (uint64_t*)MTIME;
     return *mtime;
 }
+
+// CSR_READ64 defines a function returning the 64-bit counter CSR csr. On rv32
+// the counter is split in two CSRs, so re-read the high half to catch the low
+// half wrapping around in between.
+#if XLEN == 32
+#define CSR_READ64(func, csr)                                   \
+uint64_t func() {                                               \
+    uint32_t hi, lo, hi2;                                       \
+    do {                                                        \
+        asm volatile ("csrr %0, " #csr "h" : "=r"(hi));         \
+        asm volatile ("csrr %0, " #csr : "=r"(lo));             \
+        asm volatile ("csrr %0, " #csr "h" : "=r"(hi2));        \
+    } while (hi != hi2);                                        \
+    return (uint64_t)hi << 32 | lo;                             \
+}
+#else
+#define CSR_READ64(func, csr)                                   \
+uint64_t func() {                                               \
+    uint64_t value;                                             \
+    asm volatile ("csrr %0, " #csr : "=r"(value));              \
+    return value;                                               \
+}
+#endif
+
+// get_mcycle returns the number of cycles the hart has executed.
+CSR_READ64(get_mcycle, mcycle)
+
+// get_minstret returns the number of instructions the hart has retired.
+CSR_READ64(get_minstret, minstret)
+
+// get_mhpmcounter3 and get_mhpmcounter4 return the counts of the events
+// selected with set_mhpmevent3 and set_mhpmevent4.
+CSR_READ64(get_mhpmcounter3, mhpmcounter3)
+CSR_READ64(get_mhpmcounter4, mhpmcounter4)
+
+void set_mhpmevent3(regsize_t event) {
+    asm volatile ("csrw mhpmevent3, %0" : : "r"(event));
+}
+
+void set_mhpmevent4(regsize_t event) {
+    asm volatile ("csrw mhpmevent4, %0" : : "r"(event));
+}
@@ -0,0 +1,48 @@
+#include "semihost.h"
+
+regsize_t semihost_call(regsize_t op, regsize_t *args) {
+    register regsize_t a0 asm("a0") = op;
+    register regsize_t a1 asm("a1") = (regsize_t)args;
+    // The host recognizes the call by the instructions around the ebreak,
+    // which must be uncompressed and all on the same page:
+    asm volatile (
+        ".option push\n"
+        ".option norvc\n"
+        ".balign 16\n"
+        "slli   x0, x0, 0x1f\n"
+        "ebreak\n"
+        "srai   x0, x0, 7\n"
+        ".option pop\n"
+        : "+r"(a0)
+        : "r"(a1)
+        : "memory"
+    );
+    return a0;
+}
+
+int32_t semihost_open(char const *name, uint32_t mode) {
+    uint32_t len = 0;
+    while (name[len]) {
+        len++;
+    }
+    regsize_t args[3];
+    args[0] = (regsize_t)name;
+    args[1] = mode;
+    args[2] = len;
+    return (int32_t)semihost_call(SEMIHOST_SYS_OPEN, args);
+}
+
+int32_t semihost_write(int32_t fd, void const *buf, uint32_t len) {
+    regsize_t args[3];
+    args[0] = fd;
+    args[1] = (regsize_t)buf;
+    args[2] = len;
+    // SYS_WRITE returns the number of bytes that were *not* written:
+    return semihost_call(SEMIHOST_SYS_WRITE, args) == 0 ? 0 : -1;
+}
+
+int32_t semihost_close(int32_t fd) {
+    regsize_t args[1];
+    args[0] = fd;
+    return (int32_t)semihost_call(SEMIHOST_SYS_CLOSE, args);
+}
@@ -0,0 +1,28 @@
+#include "stackmark.h"
+#include "pmp.h"
+
+void stack_paint(void *lo, void *hi) {
+    for (uint32_t *p = (uint32_t*)lo; (void*)p < hi; p++) {
+        *p = STACK_PAINT;
+    }
+}
+
+uint32_t stack_max_depth(void *lo, void *hi) {
+    uint32_t *p = (uint32_t*)lo;
+    while ((void*)p < hi && *p == STACK_PAINT) {
+        p++;
+    }
+    return (regsize_t)hi - (regsize_t)p;
+}
+
+void* kstack_bottom(uint32_t hart) {
+    return (void*)&stack_top - (hart + 1) * KSTACK_SIZE;
+}
+
+uint32_t kstack_max_depth(uint32_t hart) {
+    if (hart >= num_harts || kstack_bottom(hart) < (void*)&stack_bottom) {
+        return 0;
+    }
+    void *lo = kstack_bottom(hart);
+    return stack_max_depth(lo, lo + KSTACK_SIZE);
+}
@@ -0,0 +1,118 @@
+#include "strace.h"
+#include "kernel.h"
+
+strace_t strace;
+
+void strace_init() {
+    strace.lock = 0;
+    strace.next_seq = 0;
+    strace.read_seq = 0;
+    strace.num_traced = 0;
+    for (int i = 0; i < SYS_NR_COUNT; i++) {
+        strace.stats[i].count = 0;
+        strace.stats[i].traced_count = 0;
+        strace.stats[i].cycles = 0;
+        strace.stats[i].traced_cycles = 0;
+    }
+}
+
+// copy_args copies the 6 syscall args. The structs here are copied field by
+// field, since we have no memcpy() for the compiler to call.
+void copy_args(regsize_t *dst, regsize_t *src) {
+    for (int i = 0; i < 6; i++) {
+        dst[i] = src[i];
+    }
+}
+
+void strace_record(uint32_t pid, uint32_t traced, uint32_t nr, regsize_t *args,
+                   regsize_t ret, uint32_t cycles) {
+    acquire(&strace.lock);
+    syscall_stat_t *stat = &strace.stats[nr];
+    stat->count++;
+    stat->cycles += cycles;
+    if (!traced) {
+        release(&strace.lock);
+        return;
+    }
+    stat->traced_count++;
+    stat->traced_cycles += cycles;
+    if (strace.next_seq - strace.read_seq == TRACE_ENTRIES) {
+        strace.read_seq++; // drop the oldest record
+    }
+    trace_entry_t *entry = &strace.ring[strace.next_seq % TRACE_ENTRIES];
+    entry->seq = strace.next_seq++;
+    entry->pid = pid;
+    entry->nr = nr;
+    entry->nargs = syscall_info[nr].nargs;
+    copy_args(entry->args, args);
+    entry->ret = ret;
+    entry->cycles = cycles;
+    release(&strace.lock);
+}
+
+void strace_enable(process_t *proc, uint32_t enable) {
+    enable = enable ? 1 : 0;
+    if (proc->traced == enable) {
+        return;
+    }
+    acquire(&strace.lock);
+    if (enable && strace.num_traced == 0) {
+        strace.read_seq = strace.next_seq = 0;
+        for (int i = 0; i < SYS_NR_COUNT; i++) {
+            strace.stats[i].traced_count = 0;
+            strace.stats[i].traced_cycles = 0;
+        }
+    }
+    proc->traced = enable;
+    if (enable) {
+        strace.num_traced++;
+    } else {
+        strace.num_traced--;
+    }
+    release(&strace.lock);
+}
+
+void strace_fork(process_t *parent, process_t *child) {
+    child->traced = parent->traced;
+    if (child->traced) {
+        acquire(&strace.lock);
+        strace.num_traced++;
+        release(&strace.lock);
+    }
+}
+
+void strace_exit(process_t *proc) {
+    strace_enable(proc, 0);
+}
+
+uint32_t strace_read(trace_entry_t *buf, uint32_t size) {
+    uint32_t n = 0;
+    acquire(&strace.lock);
+    while (n < size && strace.read_seq != strace.next_seq) {
+        trace_entry_t *entry = &strace.ring[strace.read_seq % TRACE_ENTRIES];
+        buf[n].seq = entry->seq;
+        buf[n].pid = entry->pid;
+        buf[n].nr = entry->nr;
+        buf[n].nargs = entry->nargs;
+        copy_args(buf[n].args, entry->args);
+        buf[n].ret = entry->ret;
+        buf[n].cycles = entry->cycles;
+        strace.read_seq++;
+        n++;
+    }
+    release(&strace.lock);
+    return n;
+}
+
+int32_t strace_stat(uint32_t nr, syscall_stat_t *stat) {
+    if (nr >= SYS_NR_COUNT || syscall_vector[nr] == 0) {
+        return -1;
+    }
+    acquire(&strace.lock);
+    stat->count = strace.stats[nr].count;
+    stat->traced_count = strace.stats[nr].traced_count;
+    stat->cycles = strace.stats[nr].cycles;
+    stat->traced_cycles = strace.stats[nr].traced_cycles;
+    release(&strace.lock);
+    return 0;
+}
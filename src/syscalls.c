@@ -5,35 +5,47 @@
 #include "proc.h"
 #include "uart.h"
 #include "pagealloc.h"
-
-// for fun let's pretend syscall table is kinda like 32bit Linux on x86,
-// /usr/include/asm/unistd_32.h: __NR_restart_syscall 0, __NR_exit 1, _NR_fork 2, __NR_read 3, __NR_write 4
-//
-// Note that we place syscall_vector in a .text segment in order to have it in
-// ROM, since it's read-only after all.
-void *syscall_vector[] _text = {
-    [SYS_NR_restart]   sys_restart,
-    [SYS_NR_exit]      sys_exit,
-    [SYS_NR_fork]      sys_fork,
-    [SYS_NR_read]      sys_read,
-    [SYS_NR_write]     sys_write,
-    [SYS_NR_open]      sys_open,
-    [SYS_NR_close]     sys_close,
-    [SYS_NR_wait]      sys_wait,
-    [SYS_NR_execv]     sys_execv,
-    [SYS_NR_getpid]    sys_getpid,
-    [SYS_NR_sysinfo]   sys_sysinfo,
-    [SYS_NR_sleep]     sys_sleep,
-    [SYS_NR_plist]     sys_plist,
-    [SYS_NR_pinfo]     sys_pinfo,
-};
-
+#include "sysctl.h"
+#include "vdso.h"
+#include "div64.h"
+#include "strace.h"
+#include "profile.h"
+#include "perf.h"
+#include "ktrace.h"
+#include "export.h"
+#include "kstat.h"
+
+// syscall is called from the trap handler in boot.s. The syscall number is in
+// a7 and the arguments are in a0..a5, all of them saved in trap_frame. The
+// table of handlers is generated from syscalls.tbl, see syscalltable.c.
 void syscall() {
-    int nr = trap_frame.regs[REG_A7];
+    regsize_t nr = trap_frame.regs[REG_A7];
     trap_frame.pc += 4; // step over the ecall instruction that brought us here
-    if (nr >= 0 && nr < ARRAY_LENGTH(syscall_vector) && syscall_vector[nr] != 0) {
-        int32_t (*funcPtr)(void) = syscall_vector[nr];
-        trap_frame.regs[REG_A0] = (*funcPtr)();
+    KSTAT_INC(syscalls);
+    if (nr < SYS_NR_COUNT && syscall_vector[nr] != 0) {
+        // the handler may switch to another process and overwrite trap_frame,
+        // or even exit, so remember the caller and its args for
+        // strace_record():
+        process_t *proc = current_proc();
+        uint32_t pid = proc->pid;
+        uint32_t traced = proc->traced;
+        regsize_t args[6];
+        for (int i = 0; i < 6; i++) {
+            args[i] = trap_frame.regs[REG_A0 + i];
+        }
+        uint32_t ktraced = pid != ktrace.ignore_pid;
+        if (ktraced) {
+            KTRACE(KTRACE_EV_SYSCALL, pid, nr);
+        }
+        uint64_t start = get_mcycle();
+        regsize_t ret = syscall_vector[nr](args[0], args[1], args[2], args[3],
+                                           args[4], args[5]);
+        uint32_t cycles = (uint32_t)(get_mcycle() - start);
+        trap_frame.regs[REG_A0] = ret;
+        if (ktraced) {
+            KTRACE(KTRACE_EV_SYSRET, pid, ret);
+        }
+        strace_record(pid, traced, nr, args, ret, cycles);
     } else {
         kprintf("BAD syscall %d\n", nr);
         trap_frame.regs[REG_A0] = -1;
@@ -44,7 +56,8 @@ void sys_restart() {
     poweroff();
 }
 
-void sys_exit() {
+void sys_exit(int32_t code) {
+    // TODO: pass the exit code to the parent's wait()
     proc_exit();
 }
 
@@ -52,10 +65,7 @@ uint32_t sys_fork() {
     return proc_fork();
 }
 
-int32_t sys_read() {
-    uint32_t fd = (uint32_t)trap_frame.regs[REG_A0];
-    void *buf = (void*)trap_frame.regs[REG_A1];
-    uint32_t size = (uint32_t)trap_frame.regs[REG_A2];
+int32_t sys_read(uint32_t fd, char *buf, uint32_t size) {
     if (!buf) {
         // TODO: errno
         return -1;
@@ -66,10 +76,7 @@ int32_t sys_read() {
     return proc_read(fd, buf, size);
 }
 
-int32_t sys_write() {
-    uint32_t fd = (uint32_t)trap_frame.regs[REG_A0];
-    char const *data = (char const*)trap_frame.regs[REG_A1];
-    uint32_t size = (uint32_t)trap_frame.regs[REG_A2];
+int32_t sys_write(uint32_t fd, char const *data, uint32_t size) {
     if (!data) {
         // TODO: errno
         return -1;
@@ -80,9 +87,7 @@ int32_t sys_write() {
     return -1;
 }
 
-int32_t sys_open() {
-    char const *filepath = (char const*)trap_frame.regs[REG_A0];
-    uint32_t flags = (uint32_t)trap_frame.regs[REG_A1];
+int32_t sys_open(char const *filepath, uint32_t flags) {
     if (!filepath) {
         // TODO: errno
         return -1;
@@ -90,8 +95,7 @@ int32_t sys_open() {
     return proc_open(filepath, flags);
 }
 
-int32_t sys_close() {
-    uint32_t fd = (uint32_t)trap_frame.regs[REG_A0];
+int32_t sys_close(uint32_t fd) {
     return proc_close(fd);
 }
 
@@ -99,23 +103,24 @@ int32_t sys_wait() {
     return proc_wait();
 }
 
-uint32_t sys_execv() {
-    char const* filename = (char const*)trap_frame.regs[REG_A0];
-    char const** argv = (char const**)trap_frame.regs[REG_A1];
+uint32_t sys_execv(char const *filename, char const **argv) {
     return proc_execv(filename, argv);
 }
 
 uint32_t sys_getpid() {
     acquire(&proc_table.lock);
-    uint32_t pid = proc_table.procs[proc_table.curr_proc].pid;
+    uint32_t pid = proc_table.procs[proc_table.curr_proc]->pid;
     release(&proc_table.lock);
     return pid;
 }
 
-uint32_t sys_sysinfo() {
-    sysinfo_t* info = (sysinfo_t*)trap_frame.regs[REG_A0];
+uint32_t sys_sysinfo(sysinfo_t *info) {
+    info->uptime = (uint32_t)udiv64(time_get_now() - vdso_data.boot_time, ONE_SECOND);
     acquire(&proc_table.lock);
     info->procs = proc_table.num_procs;
+    for (int i = 0; i < ARRAY_LENGTH(info->loads); i++) {
+        info->loads[i] = proc_table.loadavg[i] << (SI_LOAD_SHIFT - FSHIFT);
+    }
     release(&proc_table.lock);
 
     acquire(&paged_memory.lock);
@@ -124,6 +129,8 @@ uint32_t sys_sysinfo() {
     info->unclaimed_start = paged_memory.unclaimed_start;
     info->unclaimed_end = paged_memory.unclaimed_end;
     release(&paged_memory.lock);
+    kstat_sum(&info->kstat);
+    info->cpu_harts = kstat_cpu_sum(info->cpu_time);
     return 0;
 }
 
@@ -138,3 +145,99 @@ uint32_t sys_plist(uint32_t *pids, uint32_t size) {
 uint32_t sys_pinfo(uint32_t pid, pinfo_t *pinfo) {
     return proc_pinfo(pid, pinfo);
 }
+
+uint32_t sys_psnap(pstat_t *buf, uint32_t size, uint32_t skip) {
+    return proc_psnap(buf, size, skip);
+}
+
+int32_t sys_sysctl(char const *name, uint32_t *oldval, uint32_t const *newval) {
+    if (!name) {
+        // TODO: set errno
+        return -1;
+    }
+    uint32_t value;
+    if (sysctl_get(name, &value) != 0) {
+        return -1;
+    }
+    if (oldval) {
+        *oldval = value;
+    }
+    if (newval) {
+        return sysctl_set(name, *newval);
+    }
+    return 0;
+}
+
+int32_t sys_ioring_setup(ioring_t *ring) {
+    return proc_ioring_setup(ring);
+}
+
+int32_t sys_ioring_enter() {
+    return proc_ioring_enter();
+}
+
+int32_t sys_clock_gettime(uint32_t clock_id, timespec_t *tp) {
+    if (clock_id != CLOCK_MONOTONIC || !tp) {
+        // TODO: errno = EINVAL
+        return -1;
+    }
+    uint64_t since_boot = time_get_now() - vdso_data.boot_time;
+    uint32_t rem;
+    tp->tv_sec = udivmod64(since_boot, ONE_SECOND, &rem);
+    tp->tv_nsec = (uint32_t)udiv64((uint64_t)rem * 1000000000, ONE_SECOND);
+    return 0;
+}
+
+int32_t sys_trace(uint32_t pid, uint32_t enable) {
+    return proc_trace(pid, enable);
+}
+
+uint32_t sys_trace_read(trace_entry_t *buf, uint32_t size) {
+    if (!buf) {
+        return 0;
+    }
+    return strace_read(buf, size);
+}
+
+int32_t sys_sysstat(uint32_t nr, syscall_stat_t *stat) {
+    if (!stat) {
+        return -1;
+    }
+    return strace_stat(nr, stat);
+}
+
+int32_t sys_nop() {
+    return 0;
+}
+
+uint32_t sys_prof_read(prof_sample_t *buf, uint32_t size) {
+    if (!buf) {
+        return 0;
+    }
+    return profile_read(buf, size);
+}
+
+int32_t sys_perfstat(uint32_t pid, perf_stat_t *stat) {
+    if (!stat) {
+        return -1;
+    }
+    return proc_perfstat(pid, stat);
+}
+
+uint32_t sys_ktrace_read(ktrace_event_t *buf, uint32_t size) {
+    if (!buf) {
+        return 0;
+    }
+    return ktrace_read(buf, size);
+}
+
+int32_t sys_export(uint32_t kind, uint32_t flags) {
+    return export_dump(kind, flags);
+}
+
+int32_t sys_schedlat(uint32_t pid, schedlat_t *lat) {
+    if (!lat) {
+        return -1;
+    }
+    return proc_schedlat(pid, lat);
+}
@@ -0,0 +1,216 @@
+// Generated by scripts/gen-syscalls.py from src/syscalls.tbl, do not edit.
+
+#include "syscalls.h"
+
+// The syscall_*() functions unpack the raw register values into the typed
+// arguments of their handlers.
+
+regsize_t syscall_restart(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    sys_restart();
+    return 0;
+}
+
+regsize_t syscall_exit(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    sys_exit((int32_t)a0);
+    return 0;
+}
+
+regsize_t syscall_fork(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_fork();
+}
+
+regsize_t syscall_read(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_read((uint32_t)a0, (char *)a1, (uint32_t)a2);
+}
+
+regsize_t syscall_write(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_write((uint32_t)a0, (char const *)a1, (uint32_t)a2);
+}
+
+regsize_t syscall_open(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_open((char const *)a0, (uint32_t)a1);
+}
+
+regsize_t syscall_close(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_close((uint32_t)a0);
+}
+
+regsize_t syscall_wait(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_wait();
+}
+
+regsize_t syscall_execv(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_execv((char const *)a0, (char const **)a1);
+}
+
+regsize_t syscall_getpid(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_getpid();
+}
+
+regsize_t syscall_sysinfo(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_sysinfo((sysinfo_t *)a0);
+}
+
+regsize_t syscall_sleep(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+#if XLEN == 32
+    return (regsize_t)(int32_t)sys_sleep((uint64_t)((uint64_t)a0 | (uint64_t)a1 << 32));
+#else
+    return (regsize_t)(int32_t)sys_sleep((uint64_t)a0);
+#endif
+}
+
+regsize_t syscall_plist(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_plist((uint32_t *)a0, (uint32_t)a1);
+}
+
+regsize_t syscall_pinfo(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_pinfo((uint32_t)a0, (pinfo_t *)a1);
+}
+
+regsize_t syscall_psnap(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_psnap((pstat_t *)a0, (uint32_t)a1, (uint32_t)a2);
+}
+
+regsize_t syscall_sysctl(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_sysctl((char const *)a0, (uint32_t *)a1, (uint32_t const *)a2);
+}
+
+regsize_t syscall_ioring_setup(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_ioring_setup((ioring_t *)a0);
+}
+
+regsize_t syscall_ioring_enter(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_ioring_enter();
+}
+
+regsize_t syscall_clock_gettime(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_clock_gettime((uint32_t)a0, (timespec_t *)a1);
+}
+
+regsize_t syscall_trace(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_trace((uint32_t)a0, (uint32_t)a1);
+}
+
+regsize_t syscall_trace_read(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_trace_read((trace_entry_t *)a0, (uint32_t)a1);
+}
+
+regsize_t syscall_sysstat(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_sysstat((uint32_t)a0, (syscall_stat_t *)a1);
+}
+
+regsize_t syscall_nop(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_nop();
+}
+
+regsize_t syscall_prof_read(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_prof_read((prof_sample_t *)a0, (uint32_t)a1);
+}
+
+regsize_t syscall_perfstat(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_perfstat((uint32_t)a0, (perf_stat_t *)a1);
+}
+
+regsize_t syscall_ktrace_read(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_ktrace_read((ktrace_event_t *)a0, (uint32_t)a1);
+}
+
+regsize_t syscall_export(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_export((uint32_t)a0, (uint32_t)a1);
+}
+
+regsize_t syscall_schedlat(regsize_t a0, regsize_t a1, regsize_t a2,
+        regsize_t a3, regsize_t a4, regsize_t a5) {
+    return (regsize_t)(int32_t)sys_schedlat((uint32_t)a0, (schedlat_t *)a1);
+}
+
+// Note that we place syscall_vector in a .text segment in order to have it in
+// ROM, since it's read-only after all.
+syscall_fn_t syscall_vector[SYS_NR_COUNT] _text = {
+    [SYS_NR_restart]     syscall_restart,
+    [SYS_NR_exit]        syscall_exit,
+    [SYS_NR_fork]        syscall_fork,
+    [SYS_NR_read]        syscall_read,
+    [SYS_NR_write]       syscall_write,
+    [SYS_NR_open]        syscall_open,
+    [SYS_NR_close]       syscall_close,
+    [SYS_NR_wait]        syscall_wait,
+    [SYS_NR_execv]       syscall_execv,
+    [SYS_NR_getpid]      syscall_getpid,
+    [SYS_NR_sysinfo]     syscall_sysinfo,
+    [SYS_NR_sleep]       syscall_sleep,
+    [SYS_NR_plist]       syscall_plist,
+    [SYS_NR_pinfo]       syscall_pinfo,
+    [SYS_NR_psnap]       syscall_psnap,
+    [SYS_NR_sysctl]      syscall_sysctl,
+    [SYS_NR_ioring_setup] syscall_ioring_setup,
+    [SYS_NR_ioring_enter] syscall_ioring_enter,
+    [SYS_NR_clock_gettime] syscall_clock_gettime,
+    [SYS_NR_trace]       syscall_trace,
+    [SYS_NR_trace_read]  syscall_trace_read,
+    [SYS_NR_sysstat]     syscall_sysstat,
+    [SYS_NR_nop]         syscall_nop,
+    [SYS_NR_prof_read]   syscall_prof_read,
+    [SYS_NR_perfstat]    syscall_perfstat,
+    [SYS_NR_ktrace_read] syscall_ktrace_read,
+    [SYS_NR_export]      syscall_export,
+    [SYS_NR_schedlat]    syscall_schedlat,
+};
+
+syscall_info_t syscall_info[SYS_NR_COUNT] _rodata = {
+    [SYS_NR_restart]     { .name = "restart", .nargs = 0 },
+    [SYS_NR_exit]        { .name = "exit", .nargs = 1 },
+    [SYS_NR_fork]        { .name = "fork", .nargs = 0 },
+    [SYS_NR_read]        { .name = "read", .nargs = 3 },
+    [SYS_NR_write]       { .name = "write", .nargs = 3 },
+    [SYS_NR_open]        { .name = "open", .nargs = 2 },
+    [SYS_NR_close]       { .name = "close", .nargs = 1 },
+    [SYS_NR_wait]        { .name = "wait", .nargs = 0 },
+    [SYS_NR_execv]       { .name = "execv", .nargs = 2 },
+    [SYS_NR_getpid]      { .name = "getpid", .nargs = 0 },
+    [SYS_NR_sysinfo]     { .name = "sysinfo", .nargs = 1 },
+    [SYS_NR_sleep]       { .name = "sleep", .nargs = 1 },
+    [SYS_NR_plist]       { .name = "plist", .nargs = 2 },
+    [SYS_NR_pinfo]       { .name = "pinfo", .nargs = 2 },
+    [SYS_NR_psnap]       { .name = "psnap", .nargs = 3 },
+    [SYS_NR_sysctl]      { .name = "sysctl", .nargs = 3 },
+    [SYS_NR_ioring_setup] { .name = "ioring_setup", .nargs = 1 },
+    [SYS_NR_ioring_enter] { .name = "ioring_enter", .nargs = 0 },
+    [SYS_NR_clock_gettime] { .name = "clock_gettime", .nargs = 2 },
+    [SYS_NR_trace]       { .name = "trace", .nargs = 2 },
+    [SYS_NR_trace_read]  { .name = "trace_read", .nargs = 2 },
+    [SYS_NR_sysstat]     { .name = "sysstat", .nargs = 2 },
+    [SYS_NR_nop]         { .name = "nop", .nargs = 0 },
+    [SYS_NR_prof_read]   { .name = "prof_read", .nargs = 2 },
+    [SYS_NR_perfstat]    { .name = "perfstat", .nargs = 2 },
+    [SYS_NR_ktrace_read] { .name = "ktrace_read", .nargs = 2 },
+    [SYS_NR_export]      { .name = "export", .nargs = 2 },
+    [SYS_NR_schedlat]    { .name = "schedlat", .nargs = 2 },
+};
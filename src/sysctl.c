@@ -0,0 +1,155 @@
+#include "sysctl.h"
+#include "kernel.h"
+#include "string.h"
+
+sysctl_table_t sysctl_table;
+
+void sysctl_init() {
+    sysctl_table.lock = 0;
+    sysctl_table.num_entries = 0;
+}
+
+int32_t sysctl_register(char const *name, uint32_t type, uint32_t *value,
+                        uint32_t min, uint32_t max) {
+    acquire(&sysctl_table.lock);
+    if (sysctl_table.num_entries >= SYSCTL_MAX_ENTRIES) {
+        release(&sysctl_table.lock);
+        kprintf("sysctl: no room for %s\n", name);
+        return -1;
+    }
+    sysctl_t *entry = &sysctl_table.entries[sysctl_table.num_entries];
+    entry->name = name;
+    entry->type = type;
+    entry->value = value;
+    if (type == SYSCTL_TYPE_BOOL) {
+        min = 0;
+        max = 1;
+    }
+    entry->min = min;
+    entry->max = max;
+    sysctl_table.num_entries++;
+    release(&sysctl_table.lock);
+    return 0;
+}
+
+// sysctl_find finds a tunable by the first len characters of name. Should be
+// called with sysctl_table.lock held.
+sysctl_t* sysctl_find(char const *name, uint32_t len) {
+    for (int i = 0; i < sysctl_table.num_entries; i++) {
+        sysctl_t *entry = &sysctl_table.entries[i];
+        if (!strncmp(entry->name, name, len) && entry->name[len] == 0) {
+            return entry;
+        }
+    }
+    return 0;
+}
+
+uint32_t sysctl_name_len(char const *name) {
+    uint32_t len = 0;
+    while (name[len] && len < SYSCTL_MAX_NAME_LEN) {
+        len++;
+    }
+    return len;
+}
+
+int32_t sysctl_get(char const *name, uint32_t *value) {
+    acquire(&sysctl_table.lock);
+    sysctl_t *entry = sysctl_find(name, sysctl_name_len(name));
+    if (!entry) {
+        release(&sysctl_table.lock);
+        // TODO: errno = ENOENT
+        return -1;
+    }
+    *value = *entry->value;
+    release(&sysctl_table.lock);
+    return 0;
+}
+
+int32_t sysctl_set_entry(sysctl_t *entry, uint32_t value) {
+    if (value < entry->min || value > entry->max) {
+        // TODO: errno = EINVAL
+        return -1;
+    }
+    *entry->value = value;
+    return 0;
+}
+
+int32_t sysctl_set(char const *name, uint32_t value) {
+    acquire(&sysctl_table.lock);
+    sysctl_t *entry = sysctl_find(name, sysctl_name_len(name));
+    if (!entry) {
+        release(&sysctl_table.lock);
+        // TODO: errno = ENOENT
+        return -1;
+    }
+    int32_t status = sysctl_set_entry(entry, value);
+    release(&sysctl_table.lock);
+    return status;
+}
+
+// sysctl_parse_uint parses a decimal or a 0x-prefixed hex number from
+// str[0..len). Returns 0 on success or -1 if str is not a number.
+int32_t sysctl_parse_uint(char const *str, uint32_t len, uint32_t *value) {
+    uint32_t base = 10;
+    uint32_t i = 0;
+    if (len > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+        base = 16;
+        i = 2;
+    }
+    if (i == len) {
+        return -1;
+    }
+    uint32_t num = 0;
+    for (; i < len; i++) {
+        char ch = str[i];
+        uint32_t digit;
+        if (ch >= '0' && ch <= '9') {
+            digit = ch - '0';
+        } else if (base == 16 && ch >= 'a' && ch <= 'f') {
+            digit = ch - 'a' + 10;
+        } else if (base == 16 && ch >= 'A' && ch <= 'F') {
+            digit = ch - 'A' + 10;
+        } else {
+            return -1;
+        }
+        num = num * base + digit;
+    }
+    *value = num;
+    return 0;
+}
+
+void sysctl_apply_bootargs(char const *bootargs) {
+    uint32_t pos = 0;
+    while (bootargs[pos]) {
+        while (bootargs[pos] == ' ') {
+            pos++;
+        }
+        uint32_t start = pos;
+        uint32_t eq = 0;
+        while (bootargs[pos] && bootargs[pos] != ' ') {
+            if (bootargs[pos] == '=' && !eq) {
+                eq = pos;
+            }
+            pos++;
+        }
+        if (!eq || eq == start) {
+            continue; // not a name=value word
+        }
+        uint32_t value;
+        acquire(&sysctl_table.lock);
+        sysctl_t *entry = sysctl_find(&bootargs[start], eq - start);
+        if (!entry) {
+            release(&sysctl_table.lock);
+            kprintf("sysctl: unknown bootarg at %d\n", start);
+            continue;
+        }
+        if (sysctl_parse_uint(&bootargs[eq + 1], pos - eq - 1, &value) != 0
+            || sysctl_set_entry(entry, value) != 0) {
+            release(&sysctl_table.lock);
+            kprintf("sysctl: bad value for %s\n", entry->name);
+            continue;
+        }
+        release(&sysctl_table.lock);
+        kprintf("sysctl: %s=%d\n", entry->name, value);
+    }
+}
@@ -11,6 +11,29 @@ MACHINE NOT SUPPORTED!
 
 .equ UART_REG_TXFIFO,   0
 
+# uart_putc prints the char in register ch, clobbering tmp1 and tmp2. On Spike
+# (HTIF defined) the console is HTIF's instead, see htif.h: it writes the
+# putchar command to tohost and waits for the reply in fromhost.
+.macro  uart_putc ch, tmp1, tmp2
+.ifdef HTIF
+        li      \tmp1, 0x0101000000000000  # HTIF_COMMAND(HTIF_DEV_CONSOLE, HTIF_CMD_PUTCHAR, 0)
+        or      \tmp1, \tmp1, \ch
+        la      \tmp2, tohost
+        sd      \tmp1, 0(\tmp2)          # write to HTIF
+        la      \tmp2, fromhost
+.Lhtif_wait\@:
+        ld      \tmp1, 0(\tmp2)          # read the reply
+        beqz    \tmp1, .Lhtif_wait\@     # until there is one
+        sd      zero, 0(\tmp2)           # and take it
+.else
+        li      \tmp1, UART_BASE
+.Luart_wait\@:
+        lw      \tmp2, UART_REG_TXFIFO(\tmp1) # read from serial
+        bltz    \tmp2, .Luart_wait\@     # until >= 0
+        sw      \ch, UART_REG_TXFIFO(\tmp1)   # write to serial
+.endif
+.endm
+
 .section .text
 .global uart_printf                     # C-like print formatted string. Supports formatting: %s, %c, %d, %i, %u, %x, %o, %p
                                         # @param[in] a0 address of NULL terminated formatted string,
@@ -81,10 +104,7 @@ uart_printf:
 
 1:      li      t1, '%'                 # handle %
         beq     t0, t1, 10f
-2:      li      t2, UART_BASE
-3:      lw      t1, UART_REG_TXFIFO(t2) # read from serial
-        bltz    t1, 3b                  # until >= 0
-        sw      t0, UART_REG_TXFIFO(t2) # write to serial
+2:      uart_putc t0, t1, t2
         addi    a0, a0, 1               # increment a0
         j       0b                      # continue
 
@@ -169,21 +189,15 @@ uart_printf:
 
 .global uart_printc
 uart_printc:                            # @param[in] a0 char
-        li      a1, UART_BASE
-1:      lw      t1, UART_REG_TXFIFO(a1) # read from serial
-        bltz    t1, 1b                  # until >= 0
-        sw      a0, UART_REG_TXFIFO(a1) # write to serial
+        uart_putc a0, a1, t1
         ret
 
 .global uart_prints
 uart_prints:                            # @param[in] a0 address of NULL terminated string
-        li      a1, UART_BASE
         mv      t2, a0                  # backup a0 for size calculation before ret
 1:      lbu     t0, (a0)                # load and zero-extend byte from address a0
         beqz    t0, 3f                  # while not null
-2:      lw      t1, UART_REG_TXFIFO(a1) # read from serial
-        bltz    t1, 2b                  # until >= 0
-        sw      t0, UART_REG_TXFIFO(a1) # write to serial
+        uart_putc t0, a1, t1
         addi    a0, a0, 1               # increment a0
         j       1b
 3:      sub     a0, a0, t2              # return the number of bytes written
@@ -1,5 +1,24 @@
 #include "sys.h"
 #include "uart.h"
+#include "htif.h"
+
+#ifdef HTIF
+
+// Spike has no UART, its console is on HTIF, which needs no setting up:
+void uart_init() {}
+
+// The host terminal is line buffered, and ends lines with '\n' where a UART
+// sends '\r', which is what uart_readline looks for.
+char uart_readchar() {
+    char ch = htif_getchar();
+    return ch == '\n' ? '\r' : ch;
+}
+
+void uart_writechar(char ch) {
+    htif_putchar(ch);
+}
+
+#else
 
 void uart_init() {
     // enable reading:
@@ -25,6 +44,8 @@ void uart_writechar(char ch) {
     *tx = ch;
 }
 
+#endif // ifdef HTIF
+
 int32_t uart_readline(char* buf, uint32_t bufsize) {
     int32_t nread = 0;
     for (;;) {
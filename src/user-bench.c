@@ -0,0 +1,274 @@
+#include "userland.h"
+
+// ubench is a suite of userland microbenchmarks, in the spirit of lmbench.
+// Each benchmark times a number of iterations of some operation, and ubench
+// prints a line per benchmark:
+//
+//     bench <name> <ops> <cycles/op> <ns/op>
+//
+// Cycles come from the cycle CSR, nanoseconds from the timer (see vdso_time()).
+// The lines are meant to be grepped out of the console output and compared
+// across commits with scripts/bench-compare.py, see 'make bench'.
+
+// ubench_result_t accumulates the measurements of a single benchmark.
+typedef struct ubench_result_s {
+    uint32_t ops;
+    uint64_t cycles;
+    uint64_t ticks;
+    uint64_t start_cycles;
+    uint64_t start_ticks;
+} ubench_result_t;
+
+// ubench_t describes a single benchmark. run performs iters iterations of the
+// benchmark, bracketing the code to be measured with ubench_start() and
+// ubench_stop(), and adding the number of operations performed to r->ops.
+typedef struct ubench_s {
+    char *name;
+    void (*run)(uint32_t iters, ubench_result_t *r);
+    uint32_t iters;
+} ubench_t;
+
+// UBENCH_FORK_BATCH is the number of children fork_alloc keeps alive at
+// once. It's kept small so that it fits HiFive1's process table.
+#define UBENCH_FORK_BATCH 2
+
+// UBENCH_UART_CHUNK is the number of bytes uart_write writes per call.
+#define UBENCH_UART_CHUNK 32
+
+char ubench_fmt[] _user_rodata = "bench %s %d %d %d\n";
+char ubench_name[] _user_rodata = "ubench";
+char ubench_dash_x[] _user_rodata = "-x";
+char ubench_file[] _user_rodata = "/home/read.me";
+char ubench_uart_line[] _user_rodata = "...............................\n";
+
+// ucycles reads the cycle CSR, which vdso_init() makes available to U-mode.
+uint64_t _userland ucycles() {
+#if XLEN == 32
+    uint32_t hi, lo, hi2;
+    do {
+        asm volatile ("rdcycleh %0" : "=r"(hi));
+        asm volatile ("rdcycle %0" : "=r"(lo));
+        asm volatile ("rdcycleh %0" : "=r"(hi2));
+    } while (hi != hi2);
+    return ((uint64_t)hi << 32) | lo;
+#else
+    uint64_t cycles;
+    asm volatile ("rdcycle %0" : "=r"(cycles));
+    return cycles;
+#endif
+}
+
+void _userland ubench_start(ubench_result_t *r) {
+    r->start_ticks = vdso_time();
+    r->start_cycles = ucycles();
+}
+
+void _userland ubench_stop(ubench_result_t *r) {
+    r->cycles += ucycles() - r->start_cycles;
+    r->ticks += vdso_time() - r->start_ticks;
+}
+
+// ubench_wait_procs sleeps until the number of processes drops to procs, i.e.
+// until the children forked since then have exited. It doesn't use wait(),
+// since that would never return if the children were already gone.
+void _userland ubench_wait_procs(uint32_t procs) {
+    sysinfo_t info;
+    for (;;) {
+        vdso_sysinfo(&info);
+        if (info.procs <= procs) {
+            return;
+        }
+        sleep(0);
+    }
+}
+
+void _userland bench_null(uint32_t iters, ubench_result_t *r) {
+    ubench_start(r);
+    for (uint32_t i = 0; i < iters; i++) {
+        nop();
+    }
+    ubench_stop(r);
+    r->ops += iters;
+}
+
+void _userland bench_getpid(uint32_t iters, ubench_result_t *r) {
+    ubench_start(r);
+    for (uint32_t i = 0; i < iters; i++) {
+        getpid();
+    }
+    ubench_stop(r);
+    r->ops += iters;
+}
+
+// bench_fork_exit_wait and bench_fork_exec wait for each child with
+// ubench_wait_procs(), since the child may well exit before the parent gets
+// to wait() for it.
+void _userland bench_fork_exit_wait(uint32_t iters, ubench_result_t *r) {
+    sysinfo_t info;
+    vdso_sysinfo(&info);
+    ubench_start(r);
+    for (uint32_t i = 0; i < iters; i++) {
+        uint32_t pid = fork();
+        if (pid == 0) {
+            exit(0);
+        }
+        ubench_wait_procs(info.procs);
+    }
+    ubench_stop(r);
+    r->ops += iters;
+}
+
+void _userland bench_fork_exec(uint32_t iters, ubench_result_t *r) {
+    char const *argv[] = {ubench_name, ubench_dash_x, 0};
+    sysinfo_t info;
+    vdso_sysinfo(&info);
+    ubench_start(r);
+    for (uint32_t i = 0; i < iters; i++) {
+        uint32_t pid = fork();
+        if (pid == 0) {
+            execv(ubench_name, argv);
+            exit(-1);
+        }
+        ubench_wait_procs(info.procs);
+    }
+    ubench_stop(r);
+    r->ops += iters;
+}
+
+// bench_ctxsw ping-pongs between a parent and a child, both giving up the CPU
+// with sleep(0) as soon as they get it. Each op is a yield followed by a
+// context switch.
+void _userland bench_ctxsw(uint32_t iters, ubench_result_t *r) {
+    sysinfo_t info;
+    vdso_sysinfo(&info);
+    uint32_t pid = fork();
+    if (pid == 0) {
+        for (uint32_t i = 0; i < iters; i++) {
+            sleep(0);
+        }
+        exit(0);
+    }
+    ubench_start(r);
+    uint32_t n = 0;
+    for (;;) {
+        sleep(0);
+        n++;
+        sysinfo_t now;
+        vdso_sysinfo(&now);
+        if (now.procs <= info.procs) {
+            break;
+        }
+    }
+    ubench_stop(r);
+    r->ops += iters + n;
+}
+
+void _userland bench_bifs(uint32_t iters, ubench_result_t *r) {
+    char buf[16];
+    ubench_start(r);
+    for (uint32_t i = 0; i < iters; i++) {
+        uint32_t fd = open(ubench_file, 0);
+        read(fd, buf, sizeof(buf));
+        close(fd);
+    }
+    ubench_stop(r);
+    r->ops += iters;
+}
+
+// bench_fork_alloc measures fork() alone, which is dominated by allocating
+// and copying the child's stack page. The children are kept alive while the
+// rest of the batch is forked, so that each fork has to find a new page.
+void _userland bench_fork_alloc(uint32_t iters, ubench_result_t *r) {
+    sysinfo_t info;
+    vdso_sysinfo(&info);
+    for (uint32_t i = 0; i < iters; i++) {
+        ubench_start(r);
+        for (int j = 0; j < UBENCH_FORK_BATCH; j++) {
+            uint32_t pid = fork();
+            if (pid == 0) {
+                sleep(1);
+                exit(0);
+            }
+        }
+        ubench_stop(r);
+        r->ops += UBENCH_FORK_BATCH;
+        ubench_wait_procs(info.procs);
+    }
+}
+
+void _userland bench_uart_write(uint32_t iters, ubench_result_t *r) {
+    ubench_start(r);
+    for (uint32_t i = 0; i < iters; i++) {
+        write(1, ubench_uart_line, UBENCH_UART_CHUNK);
+    }
+    ubench_stop(r);
+    r->ops += iters * UBENCH_UART_CHUNK;
+}
+
+char ubench_name_null[] _user_rodata = "null";
+char ubench_name_getpid[] _user_rodata = "getpid";
+char ubench_name_fork_exit_wait[] _user_rodata = "fork_exit_wait";
+char ubench_name_fork_exec[] _user_rodata = "fork_exec";
+char ubench_name_ctxsw[] _user_rodata = "ctxsw";
+char ubench_name_bifs[] _user_rodata = "bifs_open_read_close";
+char ubench_name_fork_alloc[] _user_rodata = "fork_alloc";
+char ubench_name_uart_write[] _user_rodata = "uart_write";
+
+ubench_t ubenches[] _user_rodata = {
+    {ubench_name_null, bench_null, 1000},
+    {ubench_name_getpid, bench_getpid, 1000},
+    {ubench_name_fork_exit_wait, bench_fork_exit_wait, 20},
+    {ubench_name_fork_exec, bench_fork_exec, 20},
+    {ubench_name_ctxsw, bench_ctxsw, 100},
+    {ubench_name_bifs, bench_bifs, 100},
+    {ubench_name_fork_alloc, bench_fork_alloc, 10},
+    {ubench_name_uart_write, bench_uart_write, 16},
+};
+
+void _userland ubench_zero(ubench_result_t *r) {
+    r->ops = 0;
+    r->cycles = 0;
+    r->ticks = 0;
+}
+
+void _userland run_ubench(ubench_t *b) {
+    ubench_result_t r;
+    // warm up, then start over for the real run:
+    ubench_zero(&r);
+    b->run(1, &r);
+    ubench_zero(&r);
+    b->run(b->iters, &r);
+    uint64_t ns = uudiv64(r.ticks * 1000000000, vdso_timebase_freq());
+    printf(ubench_fmt, b->name, r.ops, (uint32_t)uudiv64(r.cycles, r.ops),
+           (uint32_t)uudiv64(ns, r.ops));
+}
+
+// u_main_ubench runs all benchmarks, or only the ones named in args. When run
+// as init (e.g. with the ubench bootarg), there's nobody to return to, so it
+// powers off when done.
+int _userland u_main_ubench(int argc, char const *argv[]) {
+    int is_init = vdso_getpid() == 0;
+    if (is_init) {
+        argc = 1; // init gets no args
+    }
+    if (argc > 1 && !ustrncmp(argv[1], ubench_dash_x, 2)) {
+        exit(0); // the target of fork_exec
+        return 0;
+    }
+    for (int i = 0; i < ARRAY_LENGTH(ubenches); i++) {
+        int selected = argc < 2;
+        for (int j = 1; j < argc; j++) {
+            if (!ustrncmp(argv[j], ubenches[i].name, 24)) {
+                selected = 1;
+            }
+        }
+        if (selected) {
+            run_ubench(&ubenches[i]);
+        }
+    }
+    if (is_init) {
+        restart();
+    }
+    exit(0);
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "userland.h"
+
+// cyclictest measures how precisely sleep() wakes up, in the spirit of the
+// rt-tests tool of the same name. It sleeps for a fixed interval in a loop,
+// and compares the time it actually got to run again with the time it asked
+// to be woken up at. Optionally, it forks some CPU hogs that spin (like coma)
+// for the duration of the test, to compete with it for the harts. Prints:
+//
+//     cyclictest <interval ms> <loops> <hogs> <min us> <avg us> <max us>
+//
+// followed by the latency histogram, see print_lat_hist(). See 'make
+// cyclictest'.
+
+// CYCLICTEST_INTERVAL_MS and CYCLICTEST_LOOPS are the defaults, used when
+// they're not given on the command line, or when run as init. Few loops, since
+// with the default sched.tick each one can take a second or more.
+#define CYCLICTEST_INTERVAL_MS 10
+#define CYCLICTEST_LOOPS 20
+
+// CYCLICTEST_INIT_HOGS is the number of hogs of the second run as init, the
+// first one has none. It's kept small so that it fits HiFive1's process
+// table.
+#define CYCLICTEST_INIT_HOGS 2
+
+char cyclictest_usage[] _user_rodata =
+    "usage: cyclictest [interval_ms [loops [hogs]]]\n";
+char cyclictest_tick_name[] _user_rodata = "sched.tick";
+char cyclictest_fmt[] _user_rodata = "cyclictest %d %d %d %d %d %d\n";
+
+// cyclictest_hog spins until deadline and exits.
+void _userland cyclictest_hog(uint64_t deadline) {
+    while (vdso_time() < deadline)
+        ;
+    exit(0);
+}
+
+void _userland cyclictest_run(uint32_t interval_ms, uint32_t loops,
+                              uint32_t hogs) {
+    uint32_t freq = vdso_timebase_freq();
+    uint64_t interval = uudiv64((uint64_t)interval_ms * freq, 1000);
+    sysinfo_t info;
+    vdso_sysinfo(&info);
+    uint32_t procs = info.procs;
+    // the hogs need to outlive the test: allow for every wakeup to wait for
+    // each of them to use up its time slice.
+    uint32_t tick = freq / 100;
+    sysctl(cyclictest_tick_name, &tick, 0);
+    uint64_t slack = (uint64_t)tick * (hogs + 1);
+    uint64_t deadline = vdso_time() + (interval + slack) * (loops + 1);
+    for (uint32_t i = 0; i < hogs; i++) {
+        uint32_t pid = fork();
+        if (pid == -1) {
+            prints("ERROR: fork!\n");
+            exit(-1);
+        }
+        if (pid == 0) {
+            cyclictest_hog(deadline);
+        }
+    }
+    schedlat_t lat;
+    lat.count = 0;
+    lat.max_us = 0;
+    lat.total_us = 0;
+    for (int i = 0; i < SCHEDLAT_BUCKETS; i++) {
+        lat.buckets[i] = 0;
+    }
+    uint32_t min_us = -1;
+    for (uint32_t i = 0; i < loops; i++) {
+        uint64_t target = vdso_time() + interval;
+        sleep(interval_ms);
+        uint64_t now = vdso_time();
+        uint64_t late = now > target ? now - target : 0;
+        uint32_t us = uudiv64(late * 1000000, freq);
+        ulat_add(&lat, us);
+        if (us < min_us) {
+            min_us = us;
+        }
+    }
+    uint32_t avg_us = lat.count ? uudiv64(lat.total_us, lat.count) : 0;
+    printf(cyclictest_fmt, interval_ms, loops, hogs, lat.count ? min_us : 0,
+           avg_us, lat.max_us);
+    print_lat_hist(&lat);
+    // don't wait(), it never returns if the hogs are already gone:
+    for (;;) {
+        vdso_sysinfo(&info);
+        if (info.procs <= procs) {
+            break;
+        }
+        sleep(interval_ms);
+    }
+}
+
+// u_main_cyclictest runs the test once with the given args. As init (e.g.
+// with the cyclictest bootarg), it runs it with the defaults, first on an idle
+// system and then with CYCLICTEST_INIT_HOGS hogs, and powers off.
+int _userland u_main_cyclictest(int argc, char const *argv[]) {
+    uint32_t args[3] = {CYCLICTEST_INTERVAL_MS, CYCLICTEST_LOOPS, 0};
+    if (vdso_getpid() == 0) {
+        cyclictest_run(args[0], args[1], 0);
+        cyclictest_run(args[0], args[1], CYCLICTEST_INIT_HOGS);
+        restart();
+    }
+    for (int i = 1; i < argc && i <= 3; i++) {
+        if (uatou(argv[i], &args[i - 1]) != 0) {
+            prints(cyclictest_usage);
+            exit(-1);
+            return -1;
+        }
+    }
+    if (args[0] == 0 || args[1] == 0) {
+        prints(cyclictest_usage);
+        exit(-1);
+        return -1;
+    }
+    cyclictest_run(args[0], args[1], args[2]);
+    exit(0);
+    return 0;
+}
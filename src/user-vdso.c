@@ -0,0 +1,71 @@
+#include "userland.h"
+#include "vdso.h"
+
+// vdso_read_begin and vdso_read_retry are the reader side of the vdso seqlock.
+// Use them like this:
+//
+//     do {
+//         seq = vdso_read_begin();
+//         ... read the fields ...
+//     } while (vdso_read_retry(seq));
+uint32_t _userland vdso_read_begin() {
+    uint32_t seq = vdso_data.seq;
+    while (seq & 1) {
+        seq = vdso_data.seq; // an update is in progress
+    }
+    __sync_synchronize();
+    return seq;
+}
+
+int _userland vdso_read_retry(uint32_t seq) {
+    __sync_synchronize();
+    return vdso_data.seq != seq;
+}
+
+uint32_t _userland vdso_getpid() {
+    // a single aligned word can't be torn, no need for the seqlock
+    return vdso_data.pid;
+}
+
+uint32_t _userland vdso_timebase_freq() {
+    return vdso_data.timebase_freq; // never changes after boot
+}
+
+uint64_t _userland vdso_time() {
+#ifdef NO_TIME_CSR
+    // no way to read the timer from U-mode, settle for the latest snapshot
+    uint32_t seq;
+    uint64_t now;
+    do {
+        seq = vdso_read_begin();
+        now = vdso_data.tick_time;
+    } while (vdso_read_retry(seq));
+    return now;
+#elif XLEN == 32
+    uint32_t hi, lo, hi2;
+    do {
+        asm volatile ("rdtimeh %0" : "=r"(hi));
+        asm volatile ("rdtime %0" : "=r"(lo));
+        asm volatile ("rdtimeh %0" : "=r"(hi2));
+    } while (hi != hi2);
+    return ((uint64_t)hi << 32) | lo;
+#else
+    uint64_t now;
+    asm volatile ("rdtime %0" : "=r"(now));
+    return now;
+#endif
+}
+
+uint64_t _userland vdso_uptime() {
+    return vdso_time() - vdso_data.boot_time; // boot_time never changes
+}
+
+void _userland vdso_sysinfo(sysinfo_t *info) {
+    uint32_t seq;
+    do {
+        seq = vdso_read_begin();
+        info->totalram = vdso_data.totalram;
+        info->freeram = vdso_data.freeram;
+        info->procs = vdso_data.procs;
+    } while (vdso_read_retry(seq));
+}
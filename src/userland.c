@@ -25,6 +25,42 @@ int _userland ustrncmp(char const *a, char const *b, unsigned int num) {
     return *a - *b;
 }
 
+// uatou parses a decimal number. Returns 0 on success, or -1 if s has
+// anything other than digits in it.
+int _userland uatou(char const *s, uint32_t *val) {
+    if (!*s) {
+        return -1;
+    }
+    uint32_t n = 0;
+    for (; *s; s++) {
+        if (*s < '0' || *s > '9') {
+            return -1;
+        }
+        n = n * 10 + (*s - '0');
+    }
+    *val = n;
+    return 0;
+}
+
+// uudiv64 divides a 64-bit number by a 32-bit one. rv32 has no instruction for
+// that and we don't link against libgcc, so do it the long way there.
+uint64_t _userland uudiv64(uint64_t n, uint32_t d) {
+#if XLEN == 64
+    return n / d;
+#else
+    uint64_t q = 0;
+    uint64_t r = 0;
+    for (int i = 63; i >= 0; i--) {
+        r = (r << 1) | ((n >> i) & 1);
+        if (r >= d) {
+            r -= d;
+            q |= (uint64_t)1 << i;
+        }
+    }
+    return q;
+#endif
+}
+
 // trimright finds the end of the provided string and trims any trailing
 // whitespace characters (\n,\r,\t,' ') by overwriting them with 0. Returns the
 // new length of the string.
@@ -42,16 +78,50 @@ int _userland trimright(char *str) {
     return i + 1;
 }
 
-void _userland run_program(char *name, char *argv[]) {
+// spawn forks a child that runs the program name with argv, with its
+// syscalls traced if traced is set (see trace()). Returns the child's pid, or
+// -1 if fork() failed. The child never returns from it.
+uint32_t _userland spawn(char const *name, char const *argv[], int traced) {
     uint32_t pid = fork();
     if (pid == -1) {
         prints("ERROR: fork!\n");
-    } else if (pid == 0) { // child
-        uint32_t code = execv(name, (char const**)argv);
+        return -1;
+    }
+    if (pid == 0) { // child
+        if (traced) {
+            trace(0, 1);
+        }
+        execv(name, argv);
         // normally exec doesn't return, but if it did, it's an error:
         prints("ERROR: execv\n");
-        exit();
-    } else { // parent
+        exit(-1);
+    }
+    return pid;
+}
+
+// wait_gone sleeps poll_ms at a time until process pid has exited. Unlike
+// wait(), it returns even if pid was gone before it was called. Unless poll is
+// null, it's called with arg before each check, and once more after pid has
+// exited, to read out whatever the process left behind.
+void _userland wait_gone(uint32_t pid, uint32_t poll_ms,
+                         void (*poll)(void *arg), void *arg) {
+    for (;;) {
+        if (poll) {
+            poll(arg);
+        }
+        pinfo_t info;
+        if (pinfo(pid, &info) != 0) {
+            break;
+        }
+        sleep(poll_ms);
+    }
+    if (poll) {
+        poll(arg);
+    }
+}
+
+void _userland run_program(char *name, char *argv[]) {
+    if (spawn(name, (char const**)argv, 0) != -1) {
         wait();
     }
 }
@@ -60,15 +130,7 @@ void _userland run_program(char *name, char *argv[]) {
 // program that hangs intentionally, so it doesn't wait() on it, only sleeps
 // for a bit to allow it to run briefly.
 void _userland run_hanger() {
-    uint32_t pid = fork();
-    if (pid == -1) {
-        prints("ERROR: fork!\n");
-    } else if (pid == 0) { // child
-        uint32_t code = execv("hang", 0);
-        // normally exec doesn't return, but if it did, it's an error:
-        prints("ERROR: execv\n");
-        exit();
-    } else { // parent
+    if (spawn("hang", 0, 0) != -1) {
         sleep(1);
     }
 }
@@ -180,7 +242,7 @@ int _userland u_main_shell(int argc, char* argv[]) {
 
 int _userland u_main_hello1() {
     prints("Hello from hellosayer 1\n");
-    exit();
+    exit(0);
     return 0;
 }
 
@@ -192,7 +254,7 @@ int _userland u_main_hello2(int argc, char const* argv[]) {
     } else {
         prints("Very welcome from hellosayer 2\n");
     }
-    exit();
+    exit(0);
     return 0;
 }
 
@@ -203,23 +265,39 @@ int _userland u_main_fmt() {
     char foo[] = "foo";
     printf(fmt, 387, 0, 'X', 0xaddbeef, foo);
     printf(fmt2, 11, 12, 13, 14, 15, 16, 17, 18, 19);
-    exit();
+    exit(0);
     return 0;
 }
 
 char sysinfo_fmt[] _user_rodata = "Total RAM: %d\nFree RAM: %d\nNum procs: %d\n";
 char unclaimed_mem_fmt[] _user_rodata = "Unclaimed mem: 0x%x-0x%x (%d bytes)\n";
+char uptime_fmt[] _user_rodata = "Uptime: %d s\nLoad average:";
+char load_fmt[] _user_rodata = " %d.%d%d";
+char newline[] _user_rodata = "\n";
 char dash_f[] _user_rodata = "-f";
 
+// print_load prints a fixed-point load average with two decimal places.
+void _userland print_load(uint32_t load) {
+    uint32_t hundredths = ((load & ((1 << SI_LOAD_SHIFT) - 1)) * 100) >> SI_LOAD_SHIFT;
+    printf(load_fmt, load >> SI_LOAD_SHIFT, hundredths / 10, hundredths % 10);
+}
+
 int _userland u_main_sysinfo(int argc, char const* argv[]) {
     sysinfo_t info;
     sysinfo(&info);
     printf(sysinfo_fmt, info.totalram, info.freeram, info.procs);
+    // the rest is timing-dependent, so keep it out of the default output,
+    // which the tests compare against a golden copy
     if (argc > 1 && !ustrncmp(argv[1], dash_f, 2)) {
         printf(unclaimed_mem_fmt, info.unclaimed_start, info.unclaimed_end,
                info.unclaimed_end - info.unclaimed_start);
+        printf(uptime_fmt, info.uptime);
+        for (int i = 0; i < ARRAY_LENGTH(info.loads); i++) {
+            print_load(info.loads[i]);
+        }
+        prints(newline);
     }
-    exit();
+    exit(0);
     return 0;
 }
 
@@ -245,7 +323,15 @@ int _userland u_main_smoke_test(int argc, char const *argv[]) {
 
 char ps_header_fmt[] _user_rodata = "PID  STATE  NAME\n";
 char ps_process_info_fmt[] _user_rodata = "%d    %c      %s\n";
+char ps_long_header_fmt[] _user_rodata = "PID  PPID  STATE  PAGES  STACK  CPU(ms)  NAME\n";
+char ps_long_info_fmt[] _user_rodata = "%d    %d     %c      %d      %d    %d        %s\n";
 char ps_dash_s_flag[] _user_rodata = "-s";
+char ps_dash_l_flag[] _user_rodata = "-l";
+
+// PS_BATCH is the number of processes ps and top snapshot with a single psnap()
+// call. The buffer takes about half of the 512-byte stack, which is as much as
+// can be spared.
+#define PS_BATCH 4
 
 char _userland state_to_char(uint32_t state) {
     switch (state) {
@@ -258,37 +344,107 @@ char _userland state_to_char(uint32_t state) {
     return 'U';
 }
 
+// ps_for_each calls fn with each process and arg, reading them PS_BATCH at a
+// time with psnap(). Each batch is consistent, but the table may change
+// between batches, so a process that comes or goes meanwhile may be missed,
+// or shown twice. Returns -1 if psnap() failed.
+int _userland ps_for_each(void (*fn)(pstat_t *p, void *arg), void *arg) {
+    pstat_t procs[PS_BATCH];
+    uint32_t skip = 0;
+    uint32_t total = 0;
+    do {
+        total = psnap(procs, PS_BATCH, skip);
+        if (total == -1) {
+            return -1;
+        }
+        for (int i = 0; i < PS_BATCH && skip + i < total; i++) {
+            fn(&procs[i], arg);
+        }
+        skip += PS_BATCH;
+    } while (skip < total);
+    return 0;
+}
+
+// ps_opts_t holds the command line options of ps.
+typedef struct ps_opts_s {
+    int skip_self;
+    int long_fmt;
+    uint32_t my_pid;
+} ps_opts_t;
+
+void _userland ps_print(pstat_t *p, void *arg) {
+    ps_opts_t *opts = (ps_opts_t*)arg;
+    if (opts->skip_self && p->pid == opts->my_pid) {
+        return;
+    }
+    if (opts->long_fmt) {
+        uint32_t cpu_ms = uudiv64(p->cpu_time * 1000, ONE_SECOND);
+        printf(ps_long_info_fmt, p->pid, p->ppid, state_to_char(p->state),
+               p->pages, p->stack_max, cpu_ms, p->name);
+    } else {
+        printf(ps_process_info_fmt, p->pid, state_to_char(p->state), p->name);
+    }
+}
+
 int _userland u_main_ps(int argc, char const *argv[]) {
-    uint32_t pids[32];
-    uint32_t num_pids = plist(pids, 32);
-    if (num_pids < 0) {
-        prints("ERROR: plist\n");
+    ps_opts_t opts;
+    opts.skip_self = 0;
+    opts.long_fmt = 0;
+    opts.my_pid = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!ustrncmp(ps_dash_s_flag, argv[i], 2)) {
+            opts.skip_self = 1;
+            opts.my_pid = vdso_getpid();
+        } else if (!ustrncmp(ps_dash_l_flag, argv[i], 2)) {
+            opts.long_fmt = 1;
+        }
+    }
+    printf(opts.long_fmt ? ps_long_header_fmt : ps_header_fmt);
+    if (ps_for_each(ps_print, &opts) != 0) {
+        prints("ERROR: psnap\n");
         exit(-1);
         return -1;
     }
-    int skip_self = 0;
-    uint32_t my_pid = 0;
-    if (argc > 1 && !ustrncmp(ps_dash_s_flag, argv[1], 2)) {
-        skip_self = 1;
-        my_pid = getpid();
+    exit(0);
+    return 0;
+}
+
+// ioring_push queues a submission in ring. It's executed on the next
+// ioring_enter() or scheduler tick, whichever comes first. Returns -1 if the
+// ring is full.
+int _userland ioring_push(ioring_t *ring, uint32_t op, uint32_t fd, void *addr,
+                          uint32_t len, uint32_t user_data) {
+    uint32_t tail = ring->sq_tail;
+    if (tail - ring->sq_head >= IORING_ENTRIES) {
+        return -1;
     }
-    printf(ps_header_fmt);
-    for (int i = 0; i < num_pids; i++) {
-        if (skip_self && pids[i] == my_pid) {
-            continue;
-        }
-        pinfo_t info;
-        uint32_t status = pinfo(pids[i], &info);
-        if (status < 0 ) {
-            prints("ERROR: pinfo\n");
-            continue;
-        }
-        printf(ps_process_info_fmt, info.pid, state_to_char(info.state), info.name);
+    ioring_sqe_t *sqe = &ring->sqes[tail & IORING_MASK];
+    sqe->op = op;
+    sqe->fd = fd;
+    sqe->addr = (regsize_t)addr;
+    sqe->len = len;
+    sqe->user_data = user_data;
+    __sync_synchronize(); // publish the submission before the tail
+    ring->sq_tail = tail + 1;
+    return 0;
+}
+
+// ioring_pop reaps a completion from ring into cqe. Returns -1 if there's
+// none.
+int _userland ioring_pop(ioring_t *ring, ioring_cqe_t *cqe) {
+    uint32_t head = ring->cq_head;
+    if (head == ring->cq_tail) {
+        return -1;
     }
-    exit(0);
+    __sync_synchronize(); // don't read the completion before the tail
+    *cqe = ring->cqes[head & IORING_MASK];
+    ring->cq_head = head + 1;
     return 0;
 }
 
+// CAT_CHUNK is the size of each of cat's two buffers.
+#define CAT_CHUNK 32
+
 int _userland u_main_cat(int argc, char const *argv[]) {
     if (argc < 2) {
         exit(0);
@@ -298,22 +454,673 @@ int _userland u_main_cat(int argc, char const *argv[]) {
         prints("ERROR: open=-1\n");
         exit(0);
     }
-    char fbuf[64];
-    int32_t status = read(fd, fbuf, 64);
-    if (status == -1) {
-        prints("ERROR: read=-1\n");
-        exit(0);
+    ioring_t ring;
+    if (ioring_setup(&ring) != 0) {
+        prints("ERROR: ioring_setup\n");
+        exit(-1);
     }
-    fbuf[status] = 0;
-    prints(fbuf);
+    // Keep reading until EOF, procfs files can be longer than a single buffer.
+    // Each round trip to the kernel reads and prints two chunks: the buffers
+    // are zeroed and each read leaves room for a terminator, so each write can
+    // print its chunk as a zero-terminated string without knowing its length.
+    char bufs[2][CAT_CHUNK];
+    int done = 0;
+    while (!done) {
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < CAT_CHUNK; j++) {
+                bufs[i][j] = 0;
+            }
+            ioring_push(&ring, IORING_OP_READ, fd, bufs[i], CAT_CHUNK - 1, IORING_OP_READ);
+            ioring_push(&ring, IORING_OP_WRITE, 1, bufs[i], -1, IORING_OP_WRITE);
+        }
+        ioring_enter();
+        ioring_cqe_t cqe;
+        while (ioring_pop(&ring, &cqe) == 0) {
+            if (cqe.user_data != IORING_OP_READ) {
+                continue;
+            }
+            if (cqe.res == -1) {
+                prints("ERROR: read=-1\n");
+            }
+            if (cqe.res < CAT_CHUNK - 1) {
+                done = 1;
+            }
+        }
+    }
+    ioring_setup(0);
     close(fd);
     exit(0);
     return 0;
 }
 
+char sysctl_cat_name[] _user_rodata = "cat";
+char sysctl_proc_path[] _user_rodata = "/proc/sys";
+char sysctl_value_fmt[] _user_rodata = "%s %d\n";
+
+// u_main_sysctl lists all kernel tunables when run without args. Otherwise,
+// each arg is either a name, which prints the tunable, or name=value, which
+// changes it.
+int _userland u_main_sysctl(int argc, char const *argv[]) {
+    if (argc < 2) {
+        char *cat_args[] = {sysctl_cat_name, sysctl_proc_path, 0};
+        run_program(sysctl_cat_name, cat_args);
+        exit(0);
+        return 0;
+    }
+    for (int i = 1; i < argc; i++) {
+        char name[24];
+        int n = 0;
+        while (argv[i][n] && argv[i][n] != '=' && n < ARRAY_LENGTH(name) - 1) {
+            name[n] = argv[i][n];
+            n++;
+        }
+        name[n] = 0;
+        uint32_t value = 0;
+        if (argv[i][n] == '=') {
+            char const *num = &argv[i][n + 1];
+            while (*num >= '0' && *num <= '9') {
+                value = value * 10 + (*num - '0');
+                num++;
+            }
+            if (*num || sysctl(name, 0, &value) != 0) {
+                prints("ERROR: sysctl set\n");
+                continue;
+            }
+        }
+        if (sysctl(name, &value, 0) != 0) {
+            prints("ERROR: sysctl get\n");
+            continue;
+        }
+        printf(sysctl_value_fmt, name, value);
+    }
+    exit(0);
+    return 0;
+}
+
 // coma is a special program that hangs forever. Don't run it, and, more
 // importantly, don't wait() on it.
 int _userland u_main_coma() {
     for (;;)
         ;
 }
+
+char strace_usage[] _user_rodata = "usage: strace <program> [args...]\n";
+char strace_dropped_fmt[] _user_rodata = "... %d records dropped\n";
+char strace_call_fmt[] _user_rodata = "[%d] %s(";
+char strace_first_arg_fmt[] _user_rodata = "0x%x";
+char strace_arg_fmt[] _user_rodata = ", 0x%x";
+char strace_ret_fmt[] _user_rodata = ") = %d <%d>\n";
+char strace_summary_header[] _user_rodata = "CALLS  CYCLES     AVG      SYSCALL\n";
+char strace_summary_fmt[] _user_rodata = "%d      %d      %d      %s\n";
+
+// STRACE_BATCH is the number of trace records strace reads with a single
+// trace_read() call. It's kept small, because the buffer lives on the stack.
+#define STRACE_BATCH 2
+
+// STRACE_POLL_MS is how long strace sleeps when the trace buffer is empty.
+#define STRACE_POLL_MS 10
+
+// print_trace_entry prints a single trace record, noting any records that were
+// dropped before it. next_seq is the seq that the record is expected to have.
+void _userland print_trace_entry(trace_entry_t *e, uint32_t *next_seq) {
+    if (e->seq != *next_seq) {
+        printf(strace_dropped_fmt, e->seq - *next_seq);
+    }
+    *next_seq = e->seq + 1;
+    printf(strace_call_fmt, e->pid, usyscall_names[e->nr]);
+    for (int i = 0; i < e->nargs; i++) {
+        printf(i ? strace_arg_fmt : strace_first_arg_fmt, (uint32_t)e->args[i]);
+    }
+    printf(strace_ret_fmt, (int32_t)e->ret, e->cycles);
+}
+
+// strace_drain reads out and prints all trace records buffered in the kernel.
+// arg points to the seq the next record is expected to have.
+void _userland strace_drain(void *arg) {
+    trace_entry_t buf[STRACE_BATCH];
+    uint32_t n;
+    do {
+        n = trace_read(buf, STRACE_BATCH);
+        for (int i = 0; i < n; i++) {
+            print_trace_entry(&buf[i], (uint32_t*)arg);
+        }
+    } while (n == STRACE_BATCH);
+}
+
+// u_main_strace runs a program with tracing enabled, printing each of its
+// syscalls as they're made: the pid, the args, the return value and the number
+// of cycles spent in the kernel. After the program exits, it prints a summary
+// of the calls made by it and all of its children.
+int _userland u_main_strace(int argc, char const *argv[]) {
+    if (argc < 2) {
+        prints(strace_usage);
+        exit(-1);
+        return -1;
+    }
+    uint32_t pid = spawn(argv[1], &argv[1], 1);
+    if (pid == -1) {
+        exit(-1);
+        return -1;
+    }
+    uint32_t next_seq = 0;
+    wait_gone(pid, STRACE_POLL_MS, strace_drain, &next_seq);
+    prints(strace_summary_header);
+    for (uint32_t nr = 0; nr < SYS_NR_COUNT; nr++) {
+        syscall_stat_t stat;
+        if (sysstat(nr, &stat) != 0 || stat.traced_count == 0) {
+            continue;
+        }
+        uint32_t avg = uudiv64(stat.traced_cycles, stat.traced_count);
+        printf(strace_summary_fmt, stat.traced_count,
+               (uint32_t)stat.traced_cycles, avg, usyscall_names[nr]);
+    }
+    exit(0);
+    return 0;
+}
+
+char prof_usage[] _user_rodata = "usage: prof <program> [args...]\n";
+char prof_enable_name[] _user_rodata = "prof.enable";
+char prof_sample_fmt[] _user_rodata = "prof %d %d %c 0x%x\n";
+char prof_stats_path[] _user_rodata = "/proc/profile";
+char prof_name[] _user_rodata = "prof";
+char prof_init_program[] _user_rodata = "ubench";
+char prof_exported_fmt[] _user_rodata = "prof: %d samples exported to profile.bin\n";
+
+// PROF_BATCH is the number of samples prof reads with a single prof_read()
+// call, the buffer lives on the stack.
+#define PROF_BATCH 8
+
+// PROF_POLL_MS is how long prof sleeps between reading out the samples. It
+// should be short enough for the kernel's sample buffers not to fill up.
+#define PROF_POLL_MS 20
+
+// collect_t is a kernel buffer that prof or ktrace read out while the program
+// they run is alive. If the kernel was booted with export on, the records of
+// kind go straight to a host file, otherwise drain prints them.
+typedef struct collect_s {
+    uint32_t kind;            // EXPORT_*
+    void (*drain)(int print);
+    int32_t exported;         // records exported so far, or -1
+} collect_t;
+
+void _userland collect_start(collect_t *c, uint32_t kind, void (*drain)(int print)) {
+    c->kind = kind;
+    c->drain = drain;
+    c->exported = export(kind, 0);
+}
+
+// collect_poll moves the records buffered so far, it's passed to wait_gone().
+void _userland collect_poll(void *arg) {
+    collect_t *c = (collect_t*)arg;
+    if (c->exported >= 0) {
+        c->exported += export(c->kind, 0);
+    } else {
+        c->drain(1);
+    }
+}
+
+// collect_finish moves the last of the records, once the kernel has stopped
+// making them, closing the export file and reporting the number exported with
+// exported_fmt. Then it prints the stats file at stats_path.
+void _userland collect_finish(collect_t *c, char const *exported_fmt,
+                              char const *stats_path) {
+    if (c->exported >= 0) {
+        c->exported += export(c->kind, EXPORT_CLOSE);
+        printf(exported_fmt, c->exported);
+    } else {
+        c->drain(1);
+    }
+    uint32_t fd = open(stats_path, 0);
+    if (fd != -1) {
+        char buf[32];
+        int32_t n;
+        while ((n = read(fd, buf, sizeof(buf) - 1)) > 0) {
+            buf[n] = 0;
+            prints(buf);
+        }
+        close(fd);
+    }
+}
+
+// prof_drain reads out all samples buffered in the kernel, and unless print is
+// 0, prints them, a line per sample:
+//
+//     prof <hart> <pid> <mode> <pc>
+//
+// Where mode is 'u' for user, 'k' for kernel and 'i' for an idle hart, and pid
+// is -1 for idle harts.
+void _userland prof_drain(int print) {
+    prof_sample_t buf[PROF_BATCH];
+    for (;;) {
+        uint32_t n = prof_read(buf, PROF_BATCH);
+        for (int i = 0; print && i < n; i++) {
+            char mode = 'u';
+            if (buf[i].flags & PROF_SAMPLE_IDLE) {
+                mode = 'i';
+            } else if (buf[i].flags & PROF_SAMPLE_KERNEL) {
+                mode = 'k';
+            }
+            printf(prof_sample_fmt, buf[i].hart, buf[i].pid, mode,
+                   (uint32_t)buf[i].pc);
+        }
+        if (n < PROF_BATCH) {
+            return;
+        }
+    }
+}
+
+// u_main_prof runs a program with the sampling profiler on and prints the
+// samples as they're taken, then the profiler's stats from /proc/profile. The
+// output is meant for scripts/profile.py, which turns the raw pcs into flat
+// and per-process profiles. When run as init (with the prof bootarg, see
+// 'make profile'), it profiles ubench and powers off when done.
+int _userland u_main_prof(int argc, char const *argv[]) {
+    int is_init = vdso_getpid() == 0;
+    char const *init_argv[] = {prof_name, prof_init_program, 0};
+    if (is_init) {
+        argc = 2; // init gets no args
+        argv = init_argv;
+    }
+    if (argc < 2) {
+        prints(prof_usage);
+        exit(-1);
+        return -1;
+    }
+    uint32_t on = 1;
+    uint32_t off = 0;
+    // with export on, the samples go straight to a host file instead of the
+    // console:
+    collect_t samples;
+    collect_start(&samples, EXPORT_PROFILE, prof_drain);
+    if (sysctl(prof_enable_name, 0, &on) != 0) {
+        prints("ERROR: sysctl\n");
+        exit(-1);
+        return -1;
+    }
+    uint32_t pid = spawn(argv[1], &argv[1], 0);
+    if (pid == -1) {
+        exit(-1);
+        return -1;
+    }
+    wait_gone(pid, PROF_POLL_MS, collect_poll, &samples);
+    sysctl(prof_enable_name, 0, &off);
+    collect_finish(&samples, prof_exported_fmt, prof_stats_path);
+    if (is_init) {
+        restart();
+    }
+    exit(0);
+    return 0;
+}
+
+char perf_usage[] _user_rodata = "usage: perf <program> [args...]\n";
+char perf_header_fmt[] _user_rodata = "perf stats for '%s':\n";
+char perf_count_fmt[] _user_rodata = "%d\t%s\n";
+char perf_ipc_fmt[] _user_rodata = "%d\tinstructions\t# %d.%d%d insn per cycle\n";
+char perf_hpm_fmt[] _user_rodata = "%d\thpm%d\t\t# event 0x%x\n";
+char perf_cycles_name[] _user_rodata = "cycles";
+char perf_ms_name[] _user_rodata = "ms elapsed";
+char perf_event3_name[] _user_rodata = "perf.event3";
+char perf_event4_name[] _user_rodata = "perf.event4";
+
+// PERF_POLL_MS is how often perf checks whether the command has exited.
+#define PERF_POLL_MS 10
+
+// u_main_perf runs a command and reports the hardware counters it and its
+// children accumulated: cycles, instructions, IPC and the two programmable
+// counters, along with the events they were set to count (see the
+// perf.event3 and perf.event4 sysctls). The counts are 64-bit, but printed
+// truncated to 32 bits.
+int _userland u_main_perf(int argc, char const *argv[]) {
+    if (argc < 2) {
+        prints(perf_usage);
+        exit(-1);
+        return -1;
+    }
+    perf_stat_t before, after;
+    perfstat(0, &before);
+    uint64_t start = vdso_time();
+    uint32_t pid = spawn(argv[1], &argv[1], 0);
+    if (pid == -1) {
+        exit(-1);
+        return -1;
+    }
+    wait_gone(pid, PERF_POLL_MS, 0, 0);
+    uint64_t elapsed = vdso_time() - start;
+    perfstat(0, &after);
+    uint64_t cycles = after.children.cycles - before.children.cycles;
+    uint64_t instret = after.children.instret - before.children.instret;
+    // uudiv64 takes a 32-bit divisor, scale both down for long runs:
+    uint64_t ipc_cycles = cycles, ipc_instret = instret;
+    while (ipc_cycles >> 32) {
+        ipc_cycles >>= 1;
+        ipc_instret >>= 1;
+    }
+    uint32_t ipc = 0;
+    if (ipc_cycles) {
+        ipc = uudiv64(ipc_instret * 100, ipc_cycles);
+    }
+    printf(perf_header_fmt, argv[1]);
+    printf(perf_count_fmt, (uint32_t)cycles, perf_cycles_name);
+    printf(perf_ipc_fmt, (uint32_t)instret, ipc / 100, (ipc / 10) % 10,
+           ipc % 10);
+    uint32_t events[PERF_NUM_HPM] = {0, 0};
+    sysctl(perf_event3_name, &events[0], 0);
+    sysctl(perf_event4_name, &events[1], 0);
+    for (int i = 0; i < PERF_NUM_HPM; i++) {
+        uint64_t count = after.children.hpm[i] - before.children.hpm[i];
+        printf(perf_hpm_fmt, (uint32_t)count, i + 3, events[i]);
+    }
+    uint32_t ms = uudiv64(elapsed * 1000, vdso_timebase_freq());
+    printf(perf_count_fmt, ms, perf_ms_name);
+    exit(0);
+    return 0;
+}
+
+char ktrace_usage[] _user_rodata = "usage: ktrace <program> [args...]\n";
+char ktrace_enable_name[] _user_rodata = "ktrace.enable";
+char ktrace_ignore_name[] _user_rodata = "ktrace.ignore_pid";
+char ktrace_timebase_fmt[] _user_rodata = "ktrace-timebase %d\n";
+char ktrace_event_fmt[] _user_rodata = "ktrace %d %d %d %d %d %d\n";
+char ktrace_stats_path[] _user_rodata = "/proc/ktrace";
+char ktrace_name[] _user_rodata = "ktrace";
+char ktrace_exported_fmt[] _user_rodata = "ktrace: %d events exported to ktrace.bin\n";
+
+// KTRACE_BATCH is the number of events ktrace reads with a single
+// ktrace_read() call, the buffer lives on the stack.
+#define KTRACE_BATCH 8
+
+// KTRACE_POLL_MS is how long ktrace sleeps between reading out the events.
+#define KTRACE_POLL_MS 10
+
+// ktrace_drain reads out all events buffered in the kernel, and unless print
+// is 0, prints them, a line per event:
+//
+//     ktrace <hart> <time_hi> <time_lo> <event> <arg0> <arg1>
+//
+// Where event is one of KTRACE_EV_* and the time is split into two 32-bit
+// halves, since printf can't do 64-bit numbers.
+void _userland ktrace_drain(int print) {
+    ktrace_event_t buf[KTRACE_BATCH];
+    for (;;) {
+        uint32_t n = ktrace_read(buf, KTRACE_BATCH);
+        for (int i = 0; print && i < n; i++) {
+            ktrace_event_t *e = &buf[i];
+            printf(ktrace_event_fmt, e->hart, (uint32_t)(e->time >> 32),
+                   (uint32_t)e->time, e->event, e->args[0], e->args[1]);
+        }
+        if (n < KTRACE_BATCH) {
+            return;
+        }
+    }
+}
+
+// u_main_ktrace runs a program with kernel tracing on and prints the events
+// as they come, for scripts/ktrace-to-chrome.py to turn into a timeline. When
+// run as init (with the ktrace bootarg, see 'make ktrace'), it traces ubench
+// and powers off when done.
+int _userland u_main_ktrace(int argc, char const *argv[]) {
+    int is_init = vdso_getpid() == 0;
+    char const *init_argv[] = {ktrace_name, prof_init_program, 0};
+    if (is_init) {
+        argc = 2; // init gets no args
+        argv = init_argv;
+    }
+    if (argc < 2) {
+        prints(ktrace_usage);
+        exit(-1);
+        return -1;
+    }
+    uint32_t on = 1;
+    uint32_t off = 0;
+    uint32_t self = getpid();
+    uint32_t none = -1;
+    ktrace_drain(0); // throw away whatever is left from before
+    // with export on, the events go straight to a host file instead of the
+    // console:
+    collect_t events;
+    collect_start(&events, EXPORT_KTRACE, ktrace_drain);
+    printf(ktrace_timebase_fmt, vdso_timebase_freq());
+    // don't trace our own syscalls, printing each event would make more:
+    sysctl(ktrace_ignore_name, 0, &self);
+    if (sysctl(ktrace_enable_name, 0, &on) != 0) {
+        prints("ERROR: sysctl\n");
+        exit(-1);
+        return -1;
+    }
+    uint32_t pid = spawn(argv[1], &argv[1], 0);
+    if (pid == -1) {
+        exit(-1);
+        return -1;
+    }
+    wait_gone(pid, KTRACE_POLL_MS, collect_poll, &events);
+    sysctl(ktrace_enable_name, 0, &off);
+    sysctl(ktrace_ignore_name, 0, &none);
+    collect_finish(&events, ktrace_exported_fmt, ktrace_stats_path);
+    if (is_init) {
+        restart();
+    }
+    exit(0);
+    return 0;
+}
+
+char schedlat_usage[] _user_rodata = "usage: schedlat [pid]\n";
+char schedlat_all_fmt[] _user_rodata = "scheduling latency, all processes:\n";
+char schedlat_pid_fmt[] _user_rodata = "scheduling latency, pid %d:\n";
+char lat_summary_fmt[] _user_rodata = "count %d avg %dus max %dus\n";
+char lat_bucket_fmt[] _user_rodata = "%d\t-> %d us\t%d\t|%s\n";
+char lat_last_fmt[] _user_rodata = "%d\t-> ... us\t%d\t|%s\n";
+
+// LAT_BAR_WIDTH is the length of the bar of the fullest bucket.
+#define LAT_BAR_WIDTH 32
+
+void _userland ulat_add(schedlat_t *lat, uint32_t us) {
+    uint32_t bucket = 0;
+    while (bucket < SCHEDLAT_BUCKETS - 1 && (us >> bucket) != 0) {
+        bucket++;
+    }
+    lat->buckets[bucket]++;
+    lat->count++;
+    lat->total_us += us;
+    if (us > lat->max_us) {
+        lat->max_us = us;
+    }
+}
+
+void _userland print_lat_hist(schedlat_t *lat) {
+    uint32_t avg = 0;
+    if (lat->count) {
+        avg = uudiv64(lat->total_us, lat->count);
+    }
+    printf(lat_summary_fmt, lat->count, avg, lat->max_us);
+    // only print the range of buckets that have something in them:
+    int first = -1, last = -1;
+    uint32_t most = 0;
+    for (int i = 0; i < SCHEDLAT_BUCKETS; i++) {
+        if (lat->buckets[i]) {
+            if (first < 0) {
+                first = i;
+            }
+            last = i;
+        }
+        if (lat->buckets[i] > most) {
+            most = lat->buckets[i];
+        }
+    }
+    for (int i = first; first >= 0 && i <= last; i++) {
+        char bar[LAT_BAR_WIDTH + 1];
+        uint32_t len = uudiv64((uint64_t)lat->buckets[i] * LAT_BAR_WIDTH,
+                               most);
+        if (len == 0 && lat->buckets[i]) {
+            len = 1;
+        }
+        for (uint32_t j = 0; j < len; j++) {
+            bar[j] = '#';
+        }
+        bar[len] = 0;
+        uint32_t lo = i ? 1 << (i - 1) : 0;
+        if (i == SCHEDLAT_BUCKETS - 1) {
+            printf(lat_last_fmt, lo, lat->buckets[i], bar);
+        } else {
+            printf(lat_bucket_fmt, lo, (1 << i) - 1, lat->buckets[i], bar);
+        }
+    }
+}
+
+// u_main_schedlat prints the scheduling latency histogram of the given pid,
+// or of all processes since boot: how long they waited to run after being
+// woken up, with a bar per power-of-two bucket.
+int _userland u_main_schedlat(int argc, char const *argv[]) {
+    uint32_t pid = SCHEDLAT_ALL;
+    if (argc > 1 && uatou(argv[1], &pid) != 0) {
+        prints(schedlat_usage);
+        exit(-1);
+        return -1;
+    }
+    schedlat_t lat;
+    if (schedlat(pid, &lat) != 0) {
+        prints("ERROR: no such process\n");
+        exit(-1);
+        return -1;
+    }
+    if (pid == SCHEDLAT_ALL) {
+        prints(schedlat_all_fmt);
+    } else {
+        printf(schedlat_pid_fmt, pid);
+    }
+    print_lat_hist(&lat);
+    exit(0);
+    return 0;
+}
+
+char vmstat_usage[] _user_rodata = "usage: vmstat [interval_s [count]]\n";
+char vmstat_header_fmt[] _user_rodata =
+    "procs free  trap/s irq/s sys/s cs/s idle/s alloc/s free/s forkfail\n";
+char vmstat_row_fmt[] _user_rodata = "%d     %d    %d     %d     %d     %d    ";
+char vmstat_row2_fmt[] _user_rodata = "%d     %d      %d     %d\n";
+
+// vmstat_rate returns how many times per second something happened, if it
+// happened delta times in the given number of timer ticks.
+uint32_t _userland vmstat_rate(uint32_t delta, uint64_t ticks) {
+    if (ticks == 0) {
+        return 0;
+    }
+    return uudiv64((uint64_t)delta * vdso_timebase_freq(), ticks);
+}
+
+// u_main_vmstat prints the kernel event counters (see kstat_counts_t) as
+// rates per second, a line every interval_s seconds, count times, along with
+// the number of processes and free pages. The failed forks are an absolute
+// count per interval, rather than a rate.
+int _userland u_main_vmstat(int argc, char const *argv[]) {
+    uint32_t interval = 1;
+    uint32_t count = 5;
+    if ((argc > 1 && uatou(argv[1], &interval) != 0)
+        || (argc > 2 && uatou(argv[2], &count) != 0) || interval == 0) {
+        prints(vmstat_usage);
+        exit(-1);
+        return -1;
+    }
+    // assigning structs would need memcpy, so alternate between two instead:
+    sysinfo_t infos[2];
+    uint64_t times[2];
+    sysinfo(&infos[0]);
+    times[0] = vdso_time();
+    prints(vmstat_header_fmt);
+    for (uint32_t i = 0; i < count; i++) {
+        sleep(interval * 1000);
+        kstat_counts_t *prev = &infos[i % 2].kstat;
+        kstat_counts_t *now = &infos[(i + 1) % 2].kstat;
+        sysinfo(&infos[(i + 1) % 2]);
+        times[(i + 1) % 2] = vdso_time();
+        uint64_t ticks = times[(i + 1) % 2] - times[i % 2];
+        printf(vmstat_row_fmt, infos[(i + 1) % 2].procs,
+               infos[(i + 1) % 2].freeram,
+               vmstat_rate(now->traps - prev->traps, ticks),
+               vmstat_rate(now->timer_irqs - prev->timer_irqs, ticks),
+               vmstat_rate(now->syscalls - prev->syscalls, ticks),
+               vmstat_rate(now->ctx_switches - prev->ctx_switches, ticks));
+        printf(vmstat_row2_fmt, vmstat_rate(now->idle - prev->idle, ticks),
+               vmstat_rate(now->page_allocs - prev->page_allocs, ticks),
+               vmstat_rate(now->page_frees - prev->page_frees, ticks),
+               now->fork_fails - prev->fork_fails);
+    }
+    exit(0);
+    return 0;
+}
+
+char top_usage[] _user_rodata = "usage: top [interval_s [count]]\n";
+char top_summary_fmt[] _user_rodata =
+    "up %ds, %d procs, load %d.%d%d, %d/%d pages free\n";
+char top_cpu_fmt[] _user_rodata =
+    "cpu: %d%% user, %d%% kernel, %d%% irq, %d%% idle (%d harts)\n";
+char top_header_fmt[] _user_rodata = "PID  STATE  CPU(ms)  STACK  NAME\n";
+char top_proc_fmt[] _user_rodata = "%d    %c      %d        %d    %s\n";
+
+// top_summary prints the system summary and the hart utilization since the
+// previous call, as recorded in prev_times, which it updates. The sysinfo_t
+// lives in its own frame, so that it's gone by the time the process list
+// needs the stack.
+void _userland top_summary(uint64_t *prev_times) {
+    sysinfo_t info;
+    sysinfo(&info);
+    uint32_t load = info.loads[0];
+    uint32_t frac = ((load & ((1 << SI_LOAD_SHIFT) - 1)) * 100) >> SI_LOAD_SHIFT;
+    printf(top_summary_fmt, info.uptime, info.procs, load >> SI_LOAD_SHIFT,
+           frac / 10, frac % 10, info.freeram, info.totalram);
+    uint64_t total = 0;
+    for (int i = 0; i < KSTAT_CPU_STATES; i++) {
+        total += info.cpu_time[i] - prev_times[i];
+    }
+    uint32_t pct[KSTAT_CPU_STATES];
+    // uudiv64 takes a 32-bit divisor, scale everything down for long runs:
+    uint32_t shift = 0;
+    while ((total >> shift) >> 32) {
+        shift++;
+    }
+    for (int i = 0; i < KSTAT_CPU_STATES; i++) {
+        uint64_t delta = (info.cpu_time[i] - prev_times[i]) >> shift;
+        pct[i] = total ? uudiv64(delta * 100, total >> shift) : 0;
+        prev_times[i] = info.cpu_time[i];
+    }
+    printf(top_cpu_fmt, pct[KSTAT_CPU_USER], pct[KSTAT_CPU_KERNEL],
+           pct[KSTAT_CPU_IRQ], pct[KSTAT_CPU_IDLE], info.cpu_harts);
+}
+
+void _userland top_print(pstat_t *p, void *arg) {
+    uint32_t cpu_ms = uudiv64(p->cpu_time * 1000, ONE_SECOND);
+    printf(top_proc_fmt, p->pid, state_to_char(p->state), cpu_ms,
+           p->stack_max, p->name);
+}
+
+void _userland top_procs() {
+    prints(top_header_fmt);
+    ps_for_each(top_print, 0);
+}
+
+// u_main_top prints the hart utilization over each interval_s seconds (see
+// KSTAT_CPU_*), along with the system summary and the process list, count
+// times. The first one covers the time since boot.
+int _userland u_main_top(int argc, char const *argv[]) {
+    uint32_t interval = 1;
+    uint32_t count = 5;
+    if ((argc > 1 && uatou(argv[1], &interval) != 0)
+        || (argc > 2 && uatou(argv[2], &count) != 0) || interval == 0) {
+        prints(top_usage);
+        exit(-1);
+        return -1;
+    }
+    uint64_t prev_times[KSTAT_CPU_STATES];
+    for (int i = 0; i < KSTAT_CPU_STATES; i++) {
+        prev_times[i] = 0;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (i > 0) {
+            sleep(interval * 1000);
+            prints(newline);
+        }
+        top_summary(prev_times);
+        top_procs();
+    }
+    exit(0);
+    return 0;
+}
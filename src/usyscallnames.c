@@ -0,0 +1,65 @@
+// Generated by scripts/gen-syscalls.py from src/syscalls.tbl, do not edit.
+
+#include "userland.h"
+
+// The names are in user memory, unlike syscall_info, so that userland can
+// print them, e.g. in strace.
+char usyscall_name_restart[] _user_rodata = "restart";
+char usyscall_name_exit[] _user_rodata = "exit";
+char usyscall_name_fork[] _user_rodata = "fork";
+char usyscall_name_read[] _user_rodata = "read";
+char usyscall_name_write[] _user_rodata = "write";
+char usyscall_name_open[] _user_rodata = "open";
+char usyscall_name_close[] _user_rodata = "close";
+char usyscall_name_wait[] _user_rodata = "wait";
+char usyscall_name_execv[] _user_rodata = "execv";
+char usyscall_name_getpid[] _user_rodata = "getpid";
+char usyscall_name_sysinfo[] _user_rodata = "sysinfo";
+char usyscall_name_sleep[] _user_rodata = "sleep";
+char usyscall_name_plist[] _user_rodata = "plist";
+char usyscall_name_pinfo[] _user_rodata = "pinfo";
+char usyscall_name_psnap[] _user_rodata = "psnap";
+char usyscall_name_sysctl[] _user_rodata = "sysctl";
+char usyscall_name_ioring_setup[] _user_rodata = "ioring_setup";
+char usyscall_name_ioring_enter[] _user_rodata = "ioring_enter";
+char usyscall_name_clock_gettime[] _user_rodata = "clock_gettime";
+char usyscall_name_trace[] _user_rodata = "trace";
+char usyscall_name_trace_read[] _user_rodata = "trace_read";
+char usyscall_name_sysstat[] _user_rodata = "sysstat";
+char usyscall_name_nop[] _user_rodata = "nop";
+char usyscall_name_prof_read[] _user_rodata = "prof_read";
+char usyscall_name_perfstat[] _user_rodata = "perfstat";
+char usyscall_name_ktrace_read[] _user_rodata = "ktrace_read";
+char usyscall_name_export[] _user_rodata = "export";
+char usyscall_name_schedlat[] _user_rodata = "schedlat";
+
+char *usyscall_names[SYS_NR_COUNT] _user_rodata = {
+    [SYS_NR_restart]     usyscall_name_restart,
+    [SYS_NR_exit]        usyscall_name_exit,
+    [SYS_NR_fork]        usyscall_name_fork,
+    [SYS_NR_read]        usyscall_name_read,
+    [SYS_NR_write]       usyscall_name_write,
+    [SYS_NR_open]        usyscall_name_open,
+    [SYS_NR_close]       usyscall_name_close,
+    [SYS_NR_wait]        usyscall_name_wait,
+    [SYS_NR_execv]       usyscall_name_execv,
+    [SYS_NR_getpid]      usyscall_name_getpid,
+    [SYS_NR_sysinfo]     usyscall_name_sysinfo,
+    [SYS_NR_sleep]       usyscall_name_sleep,
+    [SYS_NR_plist]       usyscall_name_plist,
+    [SYS_NR_pinfo]       usyscall_name_pinfo,
+    [SYS_NR_psnap]       usyscall_name_psnap,
+    [SYS_NR_sysctl]      usyscall_name_sysctl,
+    [SYS_NR_ioring_setup] usyscall_name_ioring_setup,
+    [SYS_NR_ioring_enter] usyscall_name_ioring_enter,
+    [SYS_NR_clock_gettime] usyscall_name_clock_gettime,
+    [SYS_NR_trace]       usyscall_name_trace,
+    [SYS_NR_trace_read]  usyscall_name_trace_read,
+    [SYS_NR_sysstat]     usyscall_name_sysstat,
+    [SYS_NR_nop]         usyscall_name_nop,
+    [SYS_NR_prof_read]   usyscall_name_prof_read,
+    [SYS_NR_perfstat]    usyscall_name_perfstat,
+    [SYS_NR_ktrace_read] usyscall_name_ktrace_read,
+    [SYS_NR_export]      usyscall_name_export,
+    [SYS_NR_schedlat]    usyscall_name_schedlat,
+};
@@ -0,0 +1,65 @@
+#include "vdso.h"
+#include "kernel.h"
+#include "spinlock.h"
+
+vdso_data_t vdso_data _vdso;
+spinlock vdso_lock;
+
+void vdso_init() {
+    vdso_lock = 0;
+    vdso_data.seq = 0;
+    vdso_begin_write();
+    vdso_data.timebase_freq = ONE_SECOND;
+    vdso_data.boot_time = time_get_now();
+    vdso_data.tick_time = vdso_data.boot_time;
+    vdso_data.pid = 0;
+    vdso_data.procs = 0;
+    vdso_data.totalram = 0;
+    vdso_data.freeram = 0;
+    vdso_data.switches = 0;
+    vdso_end_write();
+    // let U-mode read the time CSR, so that vdso_time() doesn't need to trap,
+    // and the cycle CSR, so that ubench can time things precisely:
+    set_mcounteren(MCOUNTEREN_TM | MCOUNTEREN_CY);
+}
+
+void vdso_begin_write() {
+    acquire(&vdso_lock);
+    vdso_data.seq++;
+    __sync_synchronize();
+}
+
+void vdso_end_write() {
+    __sync_synchronize();
+    vdso_data.seq++;
+    release(&vdso_lock);
+}
+
+void vdso_set_running(uint32_t pid, uint64_t now) {
+    vdso_begin_write();
+    if (vdso_data.pid != pid) {
+        vdso_data.switches++;
+    }
+    vdso_data.pid = pid;
+    vdso_data.tick_time = now;
+    vdso_end_write();
+}
+
+void vdso_set_procs(uint32_t procs) {
+    vdso_begin_write();
+    vdso_data.procs = procs;
+    vdso_end_write();
+}
+
+void vdso_set_ram(uint32_t totalram, uint32_t freeram) {
+    vdso_begin_write();
+    vdso_data.totalram = totalram;
+    vdso_data.freeram = freeram;
+    vdso_end_write();
+}
+
+void vdso_add_freeram(int32_t delta) {
+    vdso_begin_write();
+    vdso_data.freeram += delta;
+    vdso_end_write();
+}